@@ -0,0 +1,243 @@
+#pragma once
+
+// ========================
+// Kontrolní vážení (checkweigher) – balíčky na lince
+// ========================
+// Čistý C++ bez Arduino závislostí – stejný kód běží na ESP32 i v host
+// nástroji tools/replay.cpp (--check), takže se parametry dají ladit nad
+// nahraným záznamem.
+//
+// Pracuje se surovým součtem článků (rawTotalMg, bez klouzavého průměru –
+// filtr by jen přidal zpoždění) a s vlastní nulou, která se mezi kusy
+// dotahuje na prázdnou plošinu:
+//   EMPTY    -> čistá hmotnost >= loadMg: kus přijel, začíná okno měření
+//   SETTLING -> posledních settleSamples vzorků v pásmu settleBandMg:
+//               průměr = hmotnost kusu, verdikt podle cíle a tolerance;
+//               když se do windowUs neustálí, verdikt CV_UNSETTLED
+//   DONE     -> čeká, až kus odjede (pod loadMg / 2), pak zase EMPTY
+// Kus, který odjede dřív než verdikt, se jen započítá do 'aborted'.
+
+#include <stdint.h>
+#include <math.h>
+
+enum CheckWeighState {
+  CW_EMPTY    = 0,
+  CW_SETTLING = 1,
+  CW_DONE     = 2
+};
+
+enum CheckVerdict {
+  CV_NONE      = 0,
+  CV_PASS      = 1,
+  CV_UNDER     = 2,
+  CV_OVER      = 3,
+  CV_UNSETTLED = 4
+};
+
+struct CheckWeighParams {
+  int32_t  targetMg      = 100000;   // jmenovitá hmotnost kusu
+  int32_t  underMg       = 2000;     // povolený podvažek
+  int32_t  overMg        = 2000;     // povolený převažek
+  int32_t  loadMg        = 0;        // práh příjezdu kusu; 0 = polovina cíle
+  int32_t  settleBandMg  = 500;      // max rozkmit vzorků v okně ustálení
+  int      settleSamples = 6;        // kolik vzorků v pásmu (6 = 75 ms při 80 SPS)
+  uint32_t windowUs      = 800000;   // od příjezdu do verdiktu nejvýš
+};
+
+struct CheckWeighStats {
+  uint32_t total     = 0;    // verdikty
+  uint32_t pass      = 0;
+  uint32_t under     = 0;
+  uint32_t over      = 0;
+  uint32_t unsettled = 0;
+  uint32_t aborted   = 0;    // kus odjel před verdiktem
+  double   mean      = 0.0;  // mg, jen ustálené kusy (Welford)
+  double   m2        = 0.0;
+  uint64_t settleUsSum = 0;  // příjezd -> verdikt, ustálené kusy
+  uint32_t settleUsMax = 0;
+};
+
+class CheckWeigher {
+public:
+  static const int MAX_SETTLE = 16;   // strop pro settleSamples
+  static const int RATE_ITEMS = 16;   // kusů pro klouzavou propustnost
+
+  explicit CheckWeigher(const CheckWeighParams& p = CheckWeighParams()) {
+    setParams(p);
+    reset();
+  }
+
+  void setParams(const CheckWeighParams& p) {
+    params = p;
+    if (params.settleSamples < 2) params.settleSamples = 2;
+    if (params.settleSamples > MAX_SETTLE) params.settleSamples = MAX_SETTLE;
+  }
+  const CheckWeighParams& getParams() const { return params; }
+
+  // stav i nula znovu (nula se chytí z prvních vzorků)
+  void reset() {
+    state     = CW_EMPTY;
+    zeroValid = false;
+    zeroMg    = 0;
+    settleCount = 0;
+    settleHead  = 0;
+    verdict   = CV_NONE;
+    lastMg    = 0;
+  }
+
+  void resetStats() {
+    stats     = CheckWeighStats();
+    rateCount = 0;
+    rateHead  = 0;
+  }
+
+  // jeden surový vzorek (mg); vrací true, když právě padl verdikt
+  bool addSample(int32_t rawMg, uint64_t tUs) {
+    if (!zeroValid) {
+      zeroMg    = rawMg;
+      zeroValid = true;
+    }
+    int32_t net  = rawMg - zeroMg;
+    int32_t load = loadThreshold();
+
+    switch (state) {
+      case CW_EMPTY:
+        if (net >= load) {
+          state       = CW_SETTLING;
+          arrivalUs   = tUs;
+          settleCount = 0;
+          settleHead  = 0;
+          return pushSettle(net, tUs);
+        }
+        // prázdná plošina – nula pomalu sleduje drift (1/8 na vzorek)
+        if (net < load / 4 && net > -load / 4) {
+          zeroMg += (net >= 0 ? net + 4 : net - 4) / 8;
+        }
+        return false;
+
+      case CW_SETTLING:
+        if (net < load / 2) {
+          stats.aborted++;
+          state = CW_EMPTY;
+          return false;
+        }
+        return pushSettle(net, tUs);
+
+      case CW_DONE:
+      default:
+        if (net < load / 2) state = CW_EMPTY;
+        return false;
+    }
+  }
+
+  CheckWeighState getState() const { return state; }
+  CheckVerdict getVerdict() const { return verdict; }   // poslední verdikt
+  int32_t getLastMg() const { return lastMg; }          // hmotnost posledního kusu
+  int32_t getZeroMg() const { return zeroMg; }
+  const CheckWeighStats& getStats() const { return stats; }
+
+  double stddevMg() const {
+    uint32_t n = settledCount();
+    return n > 1 ? sqrt(stats.m2 / (n - 1)) : 0.0;
+  }
+
+  uint32_t meanSettleUs() const {
+    uint32_t n = settledCount();
+    return n ? (uint32_t)(stats.settleUsSum / n) : 0;
+  }
+
+  // kusů za minutu z posledních RATE_ITEMS verdiktů; v klidu plynule klesá
+  float itemsPerMinute(uint64_t nowUs) const {
+    if (rateCount < 2) return 0.0f;
+    uint64_t first = rateUs[(rateHead + RATE_ITEMS - rateCount) % RATE_ITEMS];
+    uint64_t last  = rateUs[(rateHead + RATE_ITEMS - 1) % RATE_ITEMS];
+    uint64_t span  = last - first;
+    uint64_t gap   = span / (rateCount - 1);
+    if (nowUs > last && nowUs - last > gap) span += (nowUs - last) - gap;
+    return span ? (float)((rateCount - 1) * 60e6 / (double)span) : 0.0f;
+  }
+
+private:
+  int32_t loadThreshold() const {
+    int32_t l = params.loadMg > 0 ? params.loadMg : params.targetMg / 2;
+    return l > 0 ? l : 1;
+  }
+
+  uint32_t settledCount() const {
+    return stats.total - stats.unsettled;
+  }
+
+  bool pushSettle(int32_t net, uint64_t tUs) {
+    settleBuf[settleHead] = net;
+    settleHead = (settleHead + 1) % params.settleSamples;
+    if (settleCount < params.settleSamples) settleCount++;
+
+    if (settleCount >= params.settleSamples) {
+      int32_t lo = settleBuf[0], hi = settleBuf[0];
+      int64_t sum = 0;
+      for (int i = 0; i < settleCount; i++) {
+        if (settleBuf[i] < lo) lo = settleBuf[i];
+        if (settleBuf[i] > hi) hi = settleBuf[i];
+        sum += settleBuf[i];
+      }
+      if (hi - lo <= params.settleBandMg) {
+        int64_t h = settleCount / 2;
+        finish((int32_t)(sum >= 0 ? (sum + h) / settleCount : (sum - h) / settleCount), tUs, true);
+        return true;
+      }
+    }
+
+    if (tUs - arrivalUs >= params.windowUs) {
+      finish(net, tUs, false);
+      return true;
+    }
+    return false;
+  }
+
+  void finish(int32_t mg, uint64_t tUs, bool settled) {
+    state  = CW_DONE;
+    lastMg = mg;
+    stats.total++;
+
+    if (!settled) {
+      verdict = CV_UNSETTLED;
+      stats.unsettled++;
+    } else {
+      int32_t dev = mg - params.targetMg;
+      if (dev < -params.underMg)     { verdict = CV_UNDER; stats.under++; }
+      else if (dev > params.overMg)  { verdict = CV_OVER;  stats.over++; }
+      else                           { verdict = CV_PASS;  stats.pass++; }
+
+      uint32_t n = settledCount();
+      double d = mg - stats.mean;
+      stats.mean += d / n;
+      stats.m2   += d * (mg - stats.mean);
+
+      uint32_t settleUs = (uint32_t)(tUs - arrivalUs);
+      stats.settleUsSum += settleUs;
+      if (settleUs > stats.settleUsMax) stats.settleUsMax = settleUs;
+    }
+
+    rateUs[rateHead] = tUs;
+    rateHead = (rateHead + 1) % RATE_ITEMS;
+    if (rateCount < RATE_ITEMS) rateCount++;
+  }
+
+  CheckWeighParams params;
+  CheckWeighStats  stats;
+
+  CheckWeighState state = CW_EMPTY;
+  CheckVerdict    verdict = CV_NONE;
+  bool     zeroValid = false;
+  int32_t  zeroMg    = 0;
+  int32_t  lastMg    = 0;
+  uint64_t arrivalUs = 0;
+
+  int32_t settleBuf[MAX_SETTLE];
+  int     settleCount = 0;
+  int     settleHead  = 0;
+
+  uint64_t rateUs[RATE_ITEMS];
+  int      rateCount = 0;
+  int      rateHead  = 0;
+};
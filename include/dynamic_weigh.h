@@ -0,0 +1,192 @@
+#pragma once
+
+// ========================
+// Dynamické vážení (zvíře na plošině)
+// ========================
+// Čistý C++ bez Arduino závislostí – stejný kód běží na ESP32 i v host
+// nástrojích nad nahranými záznamy.
+//
+// Princip: posuvné okno posledních vzorků -> useknutý průměr (zahodí
+// špičky od pohybu) + MAD jako robustní rozptyl. Odhady po sobě jdoucích
+// oken se sbírají do historie; jakmile se celá historie vejde do tolerance,
+// hodnota se "zamkne" (HELD) a drží, dokud zátěž nezmizí.
+
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+
+enum DynamicWeighState {
+  DW_EMPTY     = 0,   // na plošině nic není
+  DW_MEASURING = 1,   // zátěž je, sbíráme odhady
+  DW_HELD      = 2    // hodnota zamčená
+};
+
+struct DynamicWeighParams {
+  float loadThreshold = 100.0f;  // g – od kolika je "něco na váze"
+  float absTolerance  = 5.0f;    // g – minimální tolerance shody odhadů
+  float relTolerance  = 0.005f;  // 0.5 % z hodnoty
+  float trimFraction  = 0.25f;   // kolik zahodit z každé strany okna
+};
+
+class DynamicWeigher {
+public:
+  static const int WINDOW  = 32;   // vzorků v okně
+  static const int HOP     = 8;    // nový odhad po každých HOP vzorcích
+  static const int HISTORY = 6;    // kolik odhadů se musí shodnout
+
+  explicit DynamicWeigher(const DynamicWeighParams& p = DynamicWeighParams()) : params(p) {
+    reset();
+  }
+
+  void reset() {
+    count = 0;
+    head = 0;
+    sinceEstimate = 0;
+    clearHistory();
+    driftCount = 0;
+    state = DW_EMPTY;
+    estimate = 0.0f;
+    spread = 0.0f;
+    held = 0.0f;
+  }
+
+  // jeden vzorek v gramech; vrací true, když se právě zamkla hodnota
+  bool addSample(float grams) {
+    window[head] = grams;
+    head = (head + 1) % WINDOW;
+    if (count < WINDOW) count++;
+
+    if (++sinceEstimate < HOP || count < WINDOW / 2) {
+      return false;
+    }
+    sinceEstimate = 0;
+
+    computeEstimate();
+
+    // zátěž zmizela (hystereze na polovině prahu)
+    if (fabsf(median) < params.loadThreshold * 0.5f) {
+      if (state != DW_EMPTY) {
+        state = DW_EMPTY;
+        clearHistory();
+        driftCount = 0;
+      }
+      return false;
+    }
+    if (state == DW_EMPTY) {
+      if (fabsf(median) < params.loadThreshold) return false;
+      state = DW_MEASURING;
+      clearHistory();   // confidence() čte hist[0..n) – nová zátěž od začátku
+    }
+
+    pushHistory(estimate);
+
+    if (state == DW_HELD) {
+      // jiná zátěž (zvíře vystřídané) -> znovu měřit
+      if (fabsf(estimate - held) > 3.0f * tolerance(held)) {
+        if (++driftCount >= HISTORY) {
+          state = DW_MEASURING;
+          driftCount = 0;
+        }
+      } else {
+        driftCount = 0;
+      }
+      return false;
+    }
+
+    if (histCount < HISTORY) return false;
+
+    float lo = hist[0], hi = hist[0];
+    for (int i = 1; i < HISTORY; i++) {
+      lo = std::min(lo, hist[i]);
+      hi = std::max(hi, hist[i]);
+    }
+    float mid = (lo + hi) * 0.5f;
+    if (hi - lo <= tolerance(mid)) {
+      held = historyMedian();
+      state = DW_HELD;
+      driftCount = 0;
+      return true;
+    }
+    return false;
+  }
+
+  DynamicWeighState getState() const { return state; }
+  float getEstimate() const { return estimate; }   // poslední robustní odhad
+  float getSpread() const { return spread; }       // robustní sigma okna
+  float getHeld() const { return held; }           // platí v DW_HELD
+
+  // 0..1 – jak blízko je historie k zamčení
+  float confidence() const {
+    if (state == DW_HELD) return 1.0f;
+    if (histCount < 2) return 0.0f;
+    int n = std::min(histCount, HISTORY);
+    float lo = hist[0], hi = hist[0];
+    for (int i = 1; i < n; i++) {
+      lo = std::min(lo, hist[i]);
+      hi = std::max(hi, hist[i]);
+    }
+    float tol = tolerance((lo + hi) * 0.5f);
+    float c = (hi - lo <= tol) ? 1.0f : tol / (hi - lo);
+    return c * n / HISTORY;
+  }
+
+private:
+  float tolerance(float value) const {
+    return std::max(params.absTolerance, params.relTolerance * fabsf(value));
+  }
+
+  void computeEstimate() {
+    float sorted[WINDOW];
+    for (int i = 0; i < count; i++) sorted[i] = window[i];
+    std::sort(sorted, sorted + count);
+
+    median = sorted[count / 2];
+
+    int trim = (int)(count * params.trimFraction);
+    float sum = 0.0f;
+    for (int i = trim; i < count - trim; i++) sum += sorted[i];
+    estimate = sum / (count - 2 * trim);
+
+    // MAD -> sigma
+    float dev[WINDOW];
+    for (int i = 0; i < count; i++) dev[i] = fabsf(sorted[i] - median);
+    std::nth_element(dev, dev + count / 2, dev + count);
+    spread = 1.4826f * dev[count / 2];
+  }
+
+  void clearHistory() {
+    histCount = 0;
+    histHead = 0;
+  }
+
+  void pushHistory(float v) {
+    hist[histHead] = v;
+    histHead = (histHead + 1) % HISTORY;
+    if (histCount < HISTORY) histCount++;
+  }
+
+  float historyMedian() const {
+    float tmp[HISTORY];
+    for (int i = 0; i < HISTORY; i++) tmp[i] = hist[i];
+    std::sort(tmp, tmp + HISTORY);
+    return (tmp[HISTORY / 2 - 1] + tmp[HISTORY / 2]) * 0.5f;
+  }
+
+  DynamicWeighParams params;
+
+  float window[WINDOW];
+  int   count;
+  int   head;
+  int   sinceEstimate;
+
+  float hist[HISTORY];
+  int   histCount;
+  int   histHead;
+  int   driftCount;
+
+  DynamicWeighState state;
+  float median = 0.0f;
+  float estimate;
+  float spread;
+  float held;
+};
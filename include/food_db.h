@@ -0,0 +1,191 @@
+#pragma once
+
+// ========================
+// Databáze potravin (jen pro čtení, ve flash)
+// ========================
+// Binární obraz vyrábí tools/mkfooddb.cpp a nahrává se do oddílu "fooddb"
+// (partitions.csv). Na ESP32 se oddíl jen namapuje do adresního prostoru –
+// nic se nekopíruje do RAM, čteme přímo z flash přes cache.
+//
+// Rozložení (little endian, vše zarovnané na 4 B):
+//   FoodDbHeader
+//   FoodRecord[count]        seřazené podle id
+//   uint32_t nameIndex[count] indexy záznamů seřazené podle jména
+//   řetězce (ASCII, ukončené nulou)
+//
+// Hledání podle id: hustá řada id -> přímý index O(1), jinak půlení.
+// Hledání podle prefixu: kyblík podle prvního znaku + půlení v nameIndex.
+//
+// open() ověří celý obraz (indexy, offsety jmen, kyblíky) – po něm už se
+// nic nekontroluje, takže poškozený oddíl nesmí projít ani částečně.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+const uint32_t FOOD_DB_MAGIC   = 0x31424446;  // "FDB1"
+const int      FOOD_DB_BUCKETS = 37;          // a-z, 0-9, ostatní
+
+struct FoodDbHeader {
+  uint32_t magic;
+  uint32_t imageSize;
+  uint32_t count;
+  uint32_t firstId;
+  uint32_t dense;             // 1 = id == firstId + index
+  uint32_t recordsOffset;
+  uint32_t nameIndexOffset;
+  uint32_t stringsOffset;
+  uint32_t bucketStart[FOOD_DB_BUCKETS + 1];   // rozsahy v nameIndex
+};
+
+// hodnoty na 100 g, ×10 (1 desetinné místo)
+struct FoodRecord {
+  uint32_t id;
+  uint32_t nameOffset;        // od začátku řetězců
+  uint16_t kcal;
+  uint16_t protein;
+  uint16_t carbs;
+  uint16_t fat;
+};
+
+static_assert(sizeof(FoodRecord) == 16, "FoodRecord layout");
+
+class FoodDb {
+public:
+  bool open(const uint8_t* image, size_t size) {
+    base = nullptr;
+    if (!image || size < sizeof(FoodDbHeader)) return false;
+
+    const FoodDbHeader* h = (const FoodDbHeader*)image;
+    if (h->magic != FOOD_DB_MAGIC || h->imageSize > size) return false;
+    if (h->recordsOffset + (uint64_t)h->count * sizeof(FoodRecord) > h->imageSize) return false;
+    if (h->nameIndexOffset + (uint64_t)h->count * 4 > h->imageSize) return false;
+    if (h->stringsOffset > h->imageSize) return false;
+    if ((h->recordsOffset | h->nameIndexOffset) % 4) return false;
+    if (h->bucketStart[FOOD_DB_BUCKETS] != h->count) return false;
+    for (int b = 0; b < FOOD_DB_BUCKETS; b++) {
+      if (h->bucketStart[b] > h->bucketStart[b + 1]) return false;
+    }
+
+    // každé jméno musí ležet v obrazu a být ukončené nulou – stačí, když
+    // je nulový poslední bajt (mkfooddb za řetězce vždy dává nulu)
+    const FoodRecord* recs = (const FoodRecord*)(image + h->recordsOffset);
+    const uint32_t*   idx  = (const uint32_t*)(image + h->nameIndexOffset);
+    uint32_t stringsSize = h->imageSize - h->stringsOffset;
+    if (h->count > 0 && (stringsSize == 0 || image[h->imageSize - 1] != 0)) return false;
+    for (uint32_t i = 0; i < h->count; i++) {
+      if (idx[i] >= h->count) return false;
+      if (recs[i].nameOffset >= stringsSize) return false;
+    }
+
+    base      = image;
+    hdr       = h;
+    records   = (const FoodRecord*)(image + h->recordsOffset);
+    nameIndex = (const uint32_t*)(image + h->nameIndexOffset);
+    strings   = (const char*)(image + h->stringsOffset);
+    return true;
+  }
+
+  bool isOpen() const { return base != nullptr; }
+  uint32_t count() const { return base ? hdr->count : 0; }
+
+  const FoodRecord* findById(uint32_t id) const {
+    if (!base || hdr->count == 0) return nullptr;
+
+    if (hdr->dense) {
+      uint32_t idx = id - hdr->firstId;
+      return (id >= hdr->firstId && idx < hdr->count) ? &records[idx] : nullptr;
+    }
+
+    uint32_t lo = 0, hi = hdr->count;
+    while (lo < hi) {
+      uint32_t mid = (lo + hi) / 2;
+      if (records[mid].id < id) lo = mid + 1;
+      else                      hi = mid;
+    }
+    return (lo < hdr->count && records[lo].id == id) ? &records[lo] : nullptr;
+  }
+
+  // pos-tá položka v abecedním pořadí
+  const FoodRecord* byNamePos(uint32_t pos) const {
+    if (!base || pos >= hdr->count) return nullptr;
+    return &records[nameIndex[pos]];
+  }
+
+  // začátek kyblíku b v abecedním pořadí (b = FOOD_DB_BUCKETS -> count)
+  uint32_t bucketBegin(int b) const {
+    return base ? hdr->bucketStart[b] : 0;
+  }
+
+  const char* name(const FoodRecord* r) const {
+    return strings + r->nameOffset;
+  }
+
+  // první pozice v abecedním pořadí, kde jméno >= prefix (bez ohledu na velikost písmen)
+  uint32_t lowerBoundName(const char* prefix) const {
+    if (!base || prefix[0] == 0) return 0;
+    int b = bucketOf(prefix[0]);
+    uint32_t lo = hdr->bucketStart[b];
+    uint32_t hi = hdr->bucketStart[b + 1];
+
+    while (lo < hi) {
+      uint32_t mid = (lo + hi) / 2;
+      if (comparePrefix(name(byNamePos(mid)), prefix) < 0) lo = mid + 1;
+      else                                                hi = mid;
+    }
+    return lo;
+  }
+
+  // až max záznamů, jejichž jméno začíná prefixem; vrací počet
+  int searchPrefix(const char* prefix, const FoodRecord** out, int max) const {
+    int n = 0;
+    for (uint32_t pos = lowerBoundName(prefix); pos < count() && n < max; pos++) {
+      const FoodRecord* r = byNamePos(pos);
+      if (comparePrefix(name(r), prefix) != 0) break;
+      out[n++] = r;
+    }
+    return n;
+  }
+
+  static char lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+  }
+
+  static int bucketOf(char c) {
+    c = lower(c);
+    if (c >= 'a' && c <= 'z') return c - 'a';
+    if (c >= '0' && c <= '9') return 26 + (c - '0');
+    return 36;
+  }
+
+  // pořadí jmen: nejdřív kyblík prvního znaku, pak znaky bez ohledu na velikost
+  static int compareNames(const char* a, const char* b) {
+    int ba = bucketOf(a[0]), bb = bucketOf(b[0]);
+    if (ba != bb) return ba - bb;
+    for (;; a++, b++) {
+      char ca = lower(*a), cb = lower(*b);
+      if (ca != cb) return (unsigned char)ca - (unsigned char)cb;
+      if (ca == 0) return 0;
+    }
+  }
+
+  // 0 = jméno začíná prefixem, jinak pořadí jako compareNames;
+  // prázdnému prefixu vyhoví všechno
+  static int comparePrefix(const char* nm, const char* prefix) {
+    if (prefix[0] == 0) return 0;
+    int ba = bucketOf(nm[0]), bb = bucketOf(prefix[0]);
+    if (ba != bb) return ba - bb;
+    for (; *prefix; nm++, prefix++) {
+      char ca = lower(*nm), cb = lower(*prefix);
+      if (ca != cb) return (unsigned char)ca - (unsigned char)cb;
+    }
+    return 0;
+  }
+
+private:
+  const uint8_t*      base      = nullptr;
+  const FoodDbHeader* hdr       = nullptr;
+  const FoodRecord*   records   = nullptr;
+  const uint32_t*     nameIndex = nullptr;
+  const char*         strings   = nullptr;
+};
@@ -0,0 +1,240 @@
+#pragma once
+
+// ========================
+// Vstupy – tlačítko, enkodér a otáčecí gesto v HUD
+// ========================
+// Čistý C++ bez Arduino závislostí: úrovně pinů a čas (ms) se předávají
+// zvenku, takže se dá totéž prohnat i na PC simulovaným průběhem (zákmity,
+// rychlé točení, dlouhé držení) se simulovaným časem. Všechny rozdíly časů
+// jsou uint32_t – přetečení millis() po 49 dnech nevadí.
+//
+// Záruky, na které spoléhá loop():
+//   - jeden stisk dá buď klik, nebo dlouhý stisk, nikdy obojí a nikdy dvakrát
+//   - dlouhý stisk se neztratí ani když loop() stál déle než longPressMs
+//     (pak přijde při puštění)
+//   - gesto v HUD dá nejvýš jednu událost a pak začíná od nuly
+//   - výběr v seznamu je vždy v [0, count) a v zobrazeném okně
+//
+// tools/inputsim.cpp to ověřuje nad simulovanými průběhy (i fuzzing).
+
+#include <stdint.h>
+
+// ========================
+// Tlačítko enkodéru (aktivní v LOW, pull-up)
+// ========================
+const uint8_t BTN_CLICK = 1;
+const uint8_t BTN_LONG  = 2;
+
+class ButtonDecoder {
+public:
+  uint32_t debounceMs  = 30;
+  uint32_t longPressMs = 1500;
+
+  void begin(bool level, uint32_t nowMs) {
+    stateLevel  = level;
+    lastEventMs = nowMs;
+    pressStartMs = nowMs;
+    longFired   = false;
+  }
+
+  // úroveň pinu (true = HIGH = puštěno); vrací BTN_CLICK / BTN_LONG / 0
+  uint8_t update(bool level, uint32_t nowMs) {
+    uint8_t ev = 0;
+
+    // hrana se bere, jen když od poslední uplynulo víc než debounceMs
+    if (level != stateLevel && nowMs - lastEventMs > debounceMs) {
+      lastEventMs = nowMs;
+      if (!level) {
+        pressStartMs = nowMs;
+        longFired    = false;
+      } else if (!longFired) {
+        longFired = true;   // stisk je tímto vyřízený
+        ev = nowMs - pressStartMs < longPressMs ? BTN_CLICK : BTN_LONG;
+      }
+      stateLevel = level;
+    }
+
+    // dlouhý stisk už během držení
+    if (!stateLevel && !longFired && nowMs - pressStartMs >= longPressMs) {
+      longFired = true;
+      ev = BTN_LONG;
+    }
+    return ev;
+  }
+
+  bool pressed() const { return !stateLevel; }
+
+private:
+  bool     stateLevel   = true;
+  uint32_t lastEventMs  = 0;
+  uint32_t pressStartMs = 0;
+  bool     longFired    = false;
+};
+
+// ========================
+// Kvadraturní enkodér – Grayův kód, krok = návrat do klidu (A=B=1)
+// ========================
+// Čtvrtkroky se sčítají podle tabulky platných přechodů; detent se započítá
+// až po návratu do klidové polohy, když čtvrtkroky ukazují jedním směrem.
+// Zákmit jednoho kontaktu (tam a zpět) se tak vyruší a nedá krok navíc;
+// jeden přeskočený čtvrtkrok (pomalý loop) se ještě toleruje.
+// CW: 11 -> 01 -> 00 -> 10 -> 11 = +1 (jako dřív: A nahoru při B=0).
+class EncoderDecoder {
+public:
+  static const uint32_t IDLE_MS = 250;   // po pauze se rychlost počítá od nuly
+  float jumpVelocity = 40.0f;            // nad tím typeahead skoky po písmenech
+
+  void begin(bool a, bool b, uint32_t nowMs) {
+    state    = (uint8_t)((a ? 2 : 0) | (b ? 1 : 0));
+    quarter  = 0;
+    lastStepMs = nowMs - IDLE_MS - 1;
+    velocity = 0.0f;
+  }
+
+  // úrovně A a B; vrací krok -1 / 0 / +1
+  int update(bool a, bool b, uint32_t nowMs) {
+    static const int8_t QUAD[16] = {
+      //  ->00 ->01 ->10 ->11     (z řádku)
+           0,  -1,   1,   0,      // 00
+           1,   0,   0,  -1,      // 01
+          -1,   0,   0,   1,      // 10
+           0,   1,  -1,   0       // 11
+    };
+    uint8_t s = (uint8_t)((a ? 2 : 0) | (b ? 1 : 0));
+    if (s == state) return 0;
+    quarter += QUAD[state * 4 + s];
+    state = s;
+    if (s != 3) return 0;
+
+    int step = quarter >= 2 ? 1 : (quarter <= -2 ? -1 : 0);
+    quarter = 0;
+    if (step == 0) return 0;
+    pos += step;
+
+    uint32_t dt = nowMs - lastStepMs;
+    lastStepMs = nowMs;
+    if (dt > IDLE_MS)  velocity = 0.0f;
+    else if (dt > 0)   velocity = 0.6f * velocity + 0.4f * (1000.0f / dt);
+    return step;
+  }
+
+  long position() const { return pos; }
+  float getVelocity() const { return velocity; }   // detentů za sekundu (vyhlazené)
+
+  // násobitel kroku podle rychlosti; krátké seznamy jedou vždy 1:1
+  int accelFactor(int listSize, uint32_t nowMs) const {
+    if (nowMs - lastStepMs > IDLE_MS) return 1;
+
+    int f = 1;
+    if (velocity > 30.0f)      f = 10;
+    else if (velocity > 18.0f) f = 4;
+    else if (velocity > 10.0f) f = 2;
+
+    int cap = listSize / 10;
+    if (cap < 1) cap = 1;
+    return f < cap ? f : cap;
+  }
+
+  bool fastSpin(uint32_t nowMs) const {
+    return nowMs - lastStepMs <= IDLE_MS && velocity > jumpVelocity;
+  }
+
+private:
+  long     pos        = 0;
+  uint8_t  state      = 3;
+  int      quarter    = 0;      // čtvrtkroky od poslední klidové polohy
+  uint32_t lastStepMs = 0;
+  float    velocity   = 0.0f;
+};
+
+// ========================
+// Gesto v HUD: ±steps kroků -> menu
+// ========================
+// Kroky se sčítají od základny; když se enkodér idleMs nehne, základna se
+// posune na aktuální pozici (náhodné cuknutí se tak časem zapomene).
+const int HG_NONE = 0;
+const int HG_UP   = 1;    // +steps (menu TARE)
+const int HG_DOWN = -1;   // -steps (menu potravin)
+
+class HudEncoderGesture {
+public:
+  int      steps  = 5;
+  uint32_t idleMs = 2000;
+
+  // nová základna – po vstupu do HUD, po TAR overlay, když je gesto blokované
+  void reset(long pos, uint32_t nowMs) {
+    startPos = pos;
+    lastPos  = pos;
+    lastMoveMs = nowMs;
+  }
+
+  int update(long pos, uint32_t nowMs) {
+    if (pos != lastPos) {
+      lastPos    = pos;
+      lastMoveMs = nowMs;
+    } else if (nowMs - lastMoveMs > idleMs) {
+      startPos = pos;
+    }
+
+    long diff = pos - startPos;
+    if (diff >= steps || diff <= -steps) {
+      reset(pos, nowMs);
+      return diff > 0 ? HG_UP : HG_DOWN;
+    }
+    return HG_NONE;
+  }
+
+private:
+  long     startPos   = 0;
+  long     lastPos    = 0;
+  uint32_t lastMoveMs = 0;
+};
+
+// ========================
+// Výběr v seznamu (menu)
+// ========================
+// Seznam má vždy aspoň jednu položku ("Zpet"), index je v [0, count) a
+// okno top..top+rows-1 výběr obsahuje.
+struct ListCursor {
+  int count = 1;
+  int index = 0;
+  int top   = 0;      // první zobrazená položka
+
+  // výběr na idx, okno se posune jen o tolik, aby byl výběr vidět
+  void scrollTo(long idx, int rows) {
+    if (idx >= count) idx = count - 1;
+    if (idx < 0) idx = 0;
+    index = (int)idx;
+    if (index < top) top = index;
+    if (index >= top + rows) top = index - rows + 1;
+  }
+
+  // změna počtu položek (např. nová nádoba za běhu)
+  void setCount(int n, int rows) {
+    count = n < 1 ? 1 : n;
+    if (top > count - rows) top = count > rows ? count - rows : 0;
+    scrollTo(index, rows);
+  }
+
+  // delta kroků enkodéru; s jump (rychlé točení) skoky po jednom na krok,
+  // jinak delta * accel
+  void navigate(long delta, int accel, int (*jump)(int, int), int rows) {
+    if (delta == 0) return;
+    long idx = index;
+    if (jump) {
+      int  dir = delta > 0 ? 1 : -1;
+      long n   = delta > 0 ? delta : -delta;
+      for (long k = 0; k < n; k++) {
+        idx = jump((int)idx, dir);
+        if (idx < 0) idx = 0;
+        if (idx >= count) idx = count - 1;
+      }
+    } else {
+      // strop kroku, ať se násobení nepřetočí
+      if (delta > count)  delta = count;
+      if (delta < -count) delta = -count;
+      idx += delta * accel;
+    }
+    scrollTo(idx, rows);
+  }
+};
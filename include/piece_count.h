@@ -0,0 +1,192 @@
+#pragma once
+
+// ========================
+// Počítání kusů podle hmotnosti
+// ========================
+// Čistý C++ bez Arduino závislostí (jako dynamic_weigh.h / checkweigh.h).
+//
+// Jednotková hmotnost z jednoho vzorku je na šroubky a tablety málo – chyba
+// jednoho čtení se vynásobí počtem kusů. Proto:
+//   PC_ZERO      po ustálení průměr refSamples surových vzorků = nula
+//                (nádoba na váze se tím rovnou vytaruje)
+//   PC_REFERENCE uživatel položí refPieces kusů; po ustálení zase průměr
+//                refSamples vzorků -> jednotka v mikrogramech
+//   PC_COUNTING  počet = (hmotnost - nula) / jednotka. Když se při ustálení
+//                počet spolehlivě trefí do celého čísla a je větší než
+//                dosavadní reference (nejvýš refineMaxRatio ×), jednotka se
+//                z něj přepočítá – s každým přidáním se zpřesňuje.
+//
+// Spolehlivost: z rozptylu vzorků při nule a referenci se odhadne sigma
+// jednoho čtení a sigma jednotky. Počet je spolehlivý, dokud 3 sigma
+// počtu < 0.5 ks; maxReliable() je počet, nad kterým to už neplatí.
+// Vstup jsou surové mg (bez klouzavého průměru), aby sigma odpovídala
+// skutečnému šumu a průměry byly nezávislé.
+
+#include <stdint.h>
+#include <math.h>
+
+enum PieceCountState {
+  PC_ZERO      = 0,
+  PC_REFERENCE = 1,
+  PC_COUNTING  = 2
+};
+
+struct PieceCountParams {
+  int   refSamples     = 40;      // vzorků na jeden průměr (max MAX_SAMPLES)
+  float maxSigmaCount  = 1.0f / 6; // 3 sigma < 0.5 ks
+  float refineFrac     = 0.15f;   // zpřesnit, jen když je počet tak blízko celému
+  float refineMaxRatio = 2.5f;    // a nejvýš tolikrát víc kusů než dosavadní reference
+};
+
+class PieceCounter {
+public:
+  static const int MAX_SAMPLES = 64;
+
+  explicit PieceCounter(const PieceCountParams& p = PieceCountParams()) : params(p) {
+    if (params.refSamples < 4) params.refSamples = 4;
+    if (params.refSamples > MAX_SAMPLES) params.refSamples = MAX_SAMPLES;
+    start(10);
+  }
+
+  // nové počítání s referencí 'pieces' kusů
+  void start(int pieces) {
+    refPieces   = pieces < 1 ? 1 : pieces;
+    state       = PC_ZERO;
+    zeroMg      = 0;
+    unitUg      = 0;
+    sigmaSample = 0.0f;
+    sigmaZero   = 0.0f;
+    sigmaUnitUg = 0.0f;
+    refines     = 0;
+    resetAcc();
+  }
+
+  // surový vzorek (mg) + ustálení z pipeline; true = změnila se nula / jednotka
+  bool addSample(int32_t mg, bool stable) {
+    if (!stable) {
+      resetAcc();
+      return false;
+    }
+    if (state == PC_REFERENCE && mg - zeroMg < loadThreshold()) {
+      resetAcc();   // kusy ještě nejsou na váze
+      return false;
+    }
+
+    if (accN == 0) accShift = mg;
+    int64_t d = (int64_t)mg - accShift;
+    accSum   += d;
+    accSumSq += d * d;
+    if (++accN < params.refSamples) return false;
+
+    double mean  = accShift + (double)accSum / accN;
+    double var   = (accSumSq - (double)accSum * accSum / accN) / (accN - 1);
+    float  sigma = (float)sqrt(var > 0.0 ? var : 0.0);
+    int    n     = accN;
+    resetAcc();
+
+    switch (state) {
+      case PC_ZERO:
+        zeroMg      = (int32_t)lround(mean);
+        sigmaZero   = sigma;
+        sigmaSample = sigma;
+        state       = PC_REFERENCE;
+        return true;
+
+      case PC_REFERENCE:
+        if (sigma > sigmaSample) sigmaSample = sigma;
+        setUnit(mean, refPieces, n);
+        state = PC_COUNTING;
+        return true;
+
+      case PC_COUNTING:
+      default: {
+        int c = countFor((int32_t)lround(mean));
+        float frac = fabsf(exactFor((int32_t)lround(mean)) - c);
+        if (c > refPieces && c <= refPieces * params.refineMaxRatio &&
+            frac <= params.refineFrac && reliable(c)) {
+          setUnit(mean, c, n);
+          refines++;
+          return true;
+        }
+        return false;
+      }
+    }
+  }
+
+  PieceCountState getState() const { return state; }
+  int   getRefPieces() const { return refPieces; }
+  int32_t getZeroMg() const { return zeroMg; }
+  int64_t getUnitUg() const { return unitUg; }          // jednotka v µg
+  float getSigmaSampleMg() const { return sigmaSample; }
+  int   getRefines() const { return refines; }
+
+  // přesný (neceločíselný) počet pro hmotnost mg
+  float exactFor(int32_t mg) const {
+    if (state != PC_COUNTING || unitUg <= 0) return 0.0f;
+    return (float)(((int64_t)mg - zeroMg) * 1000.0 / (double)unitUg);
+  }
+
+  int countFor(int32_t mg) const {
+    return (int)lroundf(exactFor(mg));
+  }
+
+  // sigma počtu při 'count' kusech (v kusech)
+  float sigmaCount(int count) const {
+    if (unitUg <= 0) return INFINITY;
+    float unitMg = unitUg / 1000.0f;
+    float su = count * sigmaUnitUg / 1000.0f;
+    return sqrtf(sigmaSample * sigmaSample + su * su) / unitMg;
+  }
+
+  bool reliable(int count) const {
+    return sigmaCount(count < 0 ? -count : count) <= params.maxSigmaCount;
+  }
+
+  // do kolika kusů je počet spolehlivý (0 = kus je pod rozlišením váhy)
+  int maxReliable() const {
+    if (unitUg <= 0) return 0;
+    float lim = params.maxSigmaCount * unitUg / 1000.0f;   // mg
+    float room = lim * lim - sigmaSample * sigmaSample;
+    if (room <= 0.0f) return 0;
+    if (sigmaUnitUg <= 0.0f) return 1000000;
+    float n = sqrtf(room) / (sigmaUnitUg / 1000.0f);
+    return n > 1000000.0f ? 1000000 : (int)n;
+  }
+
+private:
+  // něco musí na váze přibýt: aspoň 10 sigma šumu nuly, aspoň 10 mg
+  int32_t loadThreshold() const {
+    float t = 10.0f * sigmaZero;
+    return t > 10.0f ? (int32_t)t : 10;
+  }
+
+  void setUnit(double meanMg, int pieces, int n) {
+    refPieces = pieces;
+    unitUg    = llround((meanMg - zeroMg) * 1000.0 / pieces);
+    // chyba průměru nuly i zátěže, rozpočítaná na kusy
+    sigmaUnitUg = sigmaSample * sqrtf(2.0f / n) * 1000.0f / pieces;
+  }
+
+  void resetAcc() {
+    accN     = 0;
+    accShift = 0;
+    accSum   = 0;
+    accSumSq = 0;
+  }
+
+  PieceCountParams params;
+  PieceCountState  state = PC_ZERO;
+
+  int     refPieces   = 10;
+  int32_t zeroMg      = 0;
+  int64_t unitUg      = 0;
+  float   sigmaSample = 0.0f;   // mg, jedno surové čtení
+  float   sigmaZero   = 0.0f;
+  float   sigmaUnitUg = 0.0f;
+  int     refines     = 0;
+
+  int     accN     = 0;
+  int32_t accShift = 0;
+  int64_t accSum   = 0;
+  int64_t accSumSq = 0;
+};
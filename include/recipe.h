@@ -0,0 +1,223 @@
+#pragma once
+
+// ========================
+// Recept – postupné navažování ingrediencí
+// ========================
+// Čistý C++ bez Arduino závislostí (jako ostatní "vážicí" hlavičky).
+//
+// Recept je text, řádek = ingredience:
+//   jmeno,gramy[,tolerance_g]
+// prázdné řádky a '#' komentáře se přeskočí. Bez tolerance platí
+// max(1 g, 2 % cíle).
+//
+// Váží se kumulativně – nic se netaruje. Každý krok má základnu = celková
+// hmotnost na konci předchozího kroku, takže krok = gross - základna.
+// Když je krok ustálený v toleranci cíle aspoň holdMs, zapíše se do logu
+// skutečná hmotnost a základna se posune o ni (ne o cíl – chyba jednoho
+// kroku se tak nepřenáší do dalšího). Krok se ale musí opravdu přidat:
+// hmotnost kroku nad polovinou menšího z cíle a tolerance – jinak by malé
+// cíle (sůl, droždí: tolerance >= cíl) prošly s prázdnou váhou.
+
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+
+const int RECIPE_MAX_STEPS = 16;
+const int RECIPE_NAME_LEN  = 24;
+
+struct RecipeStep {
+  char     name[RECIPE_NAME_LEN];
+  int32_t  targetMg;
+  int32_t  tolMg;
+  // výsledek (platí pro hotové kroky)
+  int32_t  actualMg;
+  uint32_t durationMs;      // od začátku kroku do potvrzení
+  uint32_t doneEpoch;       // 0 = čas neznámý
+  bool     manual;          // potvrzeno ručně (/api/recipe/next)
+};
+
+class RecipeRunner {
+public:
+  uint32_t holdMs = 800;    // jak dlouho musí krok vydržet v toleranci
+
+  // naparsuje text; při chybě vrací false a errLine = číslo řádku
+  bool parse(const char* text, int& errLine) {
+    RecipeStep tmp[RECIPE_MAX_STEPS];
+    int n = 0;
+    int line = 0;
+    errLine = 0;
+
+    const char* p = text;
+    while (*p) {
+      line++;
+      const char* end = strchr(p, '\n');
+      size_t len = end ? (size_t)(end - p) : strlen(p);
+      char buf[96];
+      if (len >= sizeof(buf)) {
+        errLine = line;
+        return false;
+      }
+      memcpy(buf, p, len);
+      buf[len] = 0;
+      p = end ? end + 1 : p + len;
+
+      // konec řádku / mezery okolo
+      char* s = buf;
+      while (*s == ' ' || *s == '\t') s++;
+      for (int i = (int)strlen(s) - 1; i >= 0 && (s[i] == '\r' || s[i] == ' ' || s[i] == '\t'); i--) s[i] = 0;
+      if (*s == 0 || *s == '#') continue;
+
+      char* c1 = strchr(s, ',');
+      if (!c1 || n >= RECIPE_MAX_STEPS) {
+        errLine = line;
+        return false;
+      }
+      *c1 = 0;
+      char* c2 = strchr(c1 + 1, ',');
+      if (c2) *c2 = 0;
+
+      char* e;
+      double grams = strtod(c1 + 1, &e);
+      if (e == c1 + 1 || grams <= 0.0) {
+        errLine = line;
+        return false;
+      }
+      double tol = 0.0;
+      if (c2) {
+        tol = strtod(c2 + 1, &e);
+        if (e == c2 + 1 || tol < 0.0) {
+          errLine = line;
+          return false;
+        }
+      }
+
+      RecipeStep& st = tmp[n++];
+      memset(&st, 0, sizeof(st));
+      setName(st.name, s);
+      st.targetMg = (int32_t)(grams * 1000.0 + 0.5);
+      if (c2) {
+        st.tolMg = (int32_t)(tol * 1000.0 + 0.5);
+      } else {
+        st.tolMg = st.targetMg / 50;            // 2 %
+        if (st.tolMg < 1000) st.tolMg = 1000;   // aspoň 1 g
+      }
+    }
+
+    if (n == 0) {
+      errLine = line ? line : 1;
+      return false;
+    }
+    memcpy(steps, tmp, sizeof(RecipeStep) * n);
+    count   = n;
+    current = n;       // načtený, ale nespuštěný
+    return true;
+  }
+
+  // začátek receptu od aktuální hmotnosti (co už leží na váze, se nepočítá)
+  void start(int32_t grossMg, uint32_t nowMs) {
+    for (int i = 0; i < count; i++) {
+      steps[i].actualMg   = 0;
+      steps[i].durationMs = 0;
+      steps[i].doneEpoch  = 0;
+      steps[i].manual     = false;
+    }
+    current     = 0;
+    baseMg      = grossMg;
+    lastGrossMg = grossMg;      // do prvního vzorku je krok 0, ne zbytek minulého běhu
+    stepStartMs = nowMs;
+    inTol       = false;
+  }
+
+  // vzorek (gross mg, ustálení z pipeline); vrací true při přechodu na další krok
+  bool addSample(int32_t grossMg, bool stable, uint32_t nowMs, uint32_t epoch) {
+    if (!running()) return false;
+    lastGrossMg = grossMg;
+
+    const RecipeStep& st = steps[current];
+    int32_t dev = stepMg() - st.targetMg;
+    bool ok = stable && dev >= -st.tolMg && dev <= st.tolMg && stepMg() > minAddedMg(st);
+    if (!ok) {
+      inTol = false;
+      return false;
+    }
+    if (!inTol) {
+      inTol   = true;
+      inTolMs = nowMs;
+    }
+    if (nowMs - inTolMs < holdMs) return false;
+
+    advance(nowMs, epoch, false);
+    return true;
+  }
+
+  // ruční potvrzení kroku s tím, co je na váze
+  bool confirm(uint32_t nowMs, uint32_t epoch) {
+    if (!running()) return false;
+    advance(nowMs, epoch, true);
+    return true;
+  }
+
+  void stop() { current = count; }
+
+  bool running() const { return current < count; }
+  bool finished() const { return count > 0 && current >= count && steps[count - 1].durationMs > 0; }
+  int  stepCount() const { return count; }
+  int  currentStep() const { return current; }
+  const RecipeStep& step(int i) const { return steps[i]; }
+
+  // hmotnost aktuálního kroku (od základny)
+  int32_t stepMg() const { return lastGrossMg - baseMg; }
+
+  // 0..1000 promile cíle (i přes 1000 při převažku, strop 2000)
+  int progressPermille(int i) const {
+    if (i < current) return steps[i].targetMg ? permille(steps[i].actualMg, steps[i].targetMg) : 0;
+    if (i > current || !running()) return 0;
+    return permille(stepMg(), steps[i].targetMg);
+  }
+
+  static void setName(char* dst, const char* src) {
+    size_t j = 0;
+    for (; *src && j < RECIPE_NAME_LEN - 1; src++) {
+      char c = *src;
+      if (c == '"' || c == '\\' || (uint8_t)c < 0x20) continue;
+      dst[j++] = c;
+    }
+    dst[j] = 0;
+  }
+
+private:
+  // kolik musí v kroku aspoň přibýt, aby se mohl počítat jako hotový
+  static int32_t minAddedMg(const RecipeStep& st) {
+    return (st.targetMg < st.tolMg ? st.targetMg : st.tolMg) / 2;
+  }
+
+  static int permille(int32_t v, int32_t target) {
+    if (v <= 0) return 0;
+    int64_t p = (int64_t)v * 1000 / target;
+    return p > 2000 ? 2000 : (int)p;
+  }
+
+  void advance(uint32_t nowMs, uint32_t epoch, bool manual) {
+    RecipeStep& st = steps[current];
+    st.actualMg   = stepMg();
+    st.durationMs = nowMs - stepStartMs;
+    if (st.durationMs == 0) st.durationMs = 1;
+    st.doneEpoch  = epoch;
+    st.manual     = manual;
+
+    baseMg     += st.actualMg;
+    stepStartMs = nowMs;
+    inTol       = false;
+    current++;
+  }
+
+  RecipeStep steps[RECIPE_MAX_STEPS];
+  int      count   = 0;
+  int      current = 0;
+
+  int32_t  baseMg      = 0;
+  int32_t  lastGrossMg = 0;
+  uint32_t stepStartMs = 0;
+  bool     inTol       = false;
+  uint32_t inTolMs     = 0;
+};
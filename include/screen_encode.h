@@ -0,0 +1,231 @@
+#pragma once
+
+// ========================
+// Snímek obrazovky jako BMP / PNG – kódování po řádcích
+// ========================
+// Čistý C++ bez Arduino závislostí. Vstup je řádek RGB565 (tak, jak ho
+// drží stínový buffer displeje), výstup jde rovnou do sítě – žádná kopie
+// celého obrázku, stačí buffer na jeden řádek (SE_MAX_ROW_BYTES).
+//
+// BMP: 24 bit, řádky odspodu (nextRowY() říká, který řádek dodat).
+// PNG: RGB 8 bit, jediný IDAT se zlib proudem z nekomprimovaných
+// ("stored") deflate bloků – blok na řádek. Velikost je tak známá předem
+// a kóduje se bez tabulek a bez paměti navíc; CRC32 a Adler-32 se
+// počítají průběžně. Obrázek je o ~0.5 % větší než surová data.
+//
+// Použití:
+//   enc.begin(SE_PNG, w, h);
+//   send(buf, enc.header(buf));
+//   while (!enc.done()) send(buf, enc.row(rowPtr(enc.nextRowY()), buf));
+//   send(buf, enc.trailer(buf));
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+enum ScreenFormat {
+  SE_BMP = 0,
+  SE_PNG = 1
+};
+
+const int SE_MAX_WIDTH     = 320;
+const int SE_MAX_ROW_BYTES = 5 + 1 + SE_MAX_WIDTH * 3;   // deflate blok + filtr + RGB
+const int SE_MAX_HEADER    = 64;
+
+class ScreenEncoder {
+public:
+  bool begin(ScreenFormat f, int w, int h) {
+    if (w < 1 || w > SE_MAX_WIDTH || h < 1 || h > 4096) return false;
+    format = f;
+    width  = w;
+    height = h;
+    rowsDone = 0;
+    crc   = 0;
+    adlerA = 1;
+    adlerB = 0;
+    return true;
+  }
+
+  const char* contentType() const {
+    return format == SE_PNG ? "image/png" : "image/bmp";
+  }
+
+  // celková délka výstupu v bajtech
+  uint32_t totalSize() const {
+    if (format == SE_BMP) return 54 + (uint32_t)bmpStride() * height;
+    return 8 + 25 + 12 + idatLength() + 12;
+  }
+
+  size_t header(uint8_t* out) {
+    return format == SE_PNG ? pngHeader(out) : bmpHeader(out);
+  }
+
+  bool done() const { return rowsDone >= height; }
+
+  // který řádek obrazovky má přijít do row()
+  int nextRowY() const {
+    return format == SE_BMP ? height - 1 - rowsDone : rowsDone;
+  }
+
+  // zakóduje řádek nextRowY(); out aspoň SE_MAX_ROW_BYTES
+  size_t row(const uint16_t* px, uint8_t* out) {
+    size_t n = 0;
+    if (format == SE_BMP) {
+      for (int x = 0; x < width; x++) {
+        uint8_t r, g, b;
+        rgb(px[x], r, g, b);
+        out[n++] = b;
+        out[n++] = g;
+        out[n++] = r;
+      }
+      while (n % 4) out[n++] = 0;
+    } else {
+      // stored blok: BFINAL na posledním řádku, LEN a NLEN little endian
+      uint16_t len = (uint16_t)(1 + width * 3);
+      out[n++] = rowsDone == height - 1 ? 1 : 0;
+      out[n++] = (uint8_t)len;
+      out[n++] = (uint8_t)(len >> 8);
+      out[n++] = (uint8_t)~len;
+      out[n++] = (uint8_t)(~len >> 8);
+      size_t data = n;
+      out[n++] = 0;   // filtr None
+      for (int x = 0; x < width; x++) {
+        rgb(px[x], out[n], out[n + 1], out[n + 2]);
+        n += 3;
+      }
+      adler(out + data, n - data);
+      crc = crc32(crc, out, n);
+    }
+    rowsDone++;
+    return n;
+  }
+
+  // konec souboru (BMP nic, PNG Adler-32 + CRC IDAT + IEND)
+  size_t trailer(uint8_t* out) {
+    if (format != SE_PNG) return 0;
+    size_t n = 0;
+    uint8_t a[4];
+    put32be(a, (adlerB << 16) | adlerA);
+    crc = crc32(crc, a, 4);
+    memcpy(out, a, 4);
+    n += 4;
+    put32be(out + n, crc);
+    n += 4;
+
+    // IEND
+    put32be(out + n, 0);
+    memcpy(out + n + 4, "IEND", 4);
+    put32be(out + n + 8, crc32(0, out + n + 4, 4));
+    n += 12;
+    return n;
+  }
+
+  // CRC-32 (IEEE, jako zlib/PNG), tabulka po 4 bitech
+  static uint32_t crc32(uint32_t c, const uint8_t* p, size_t len) {
+    static const uint32_t T[16] = {
+      0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+      0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    c = ~c;
+    for (size_t i = 0; i < len; i++) {
+      c ^= p[i];
+      c = (c >> 4) ^ T[c & 15];
+      c = (c >> 4) ^ T[c & 15];
+    }
+    return ~c;
+  }
+
+private:
+  static void rgb(uint16_t c, uint8_t& r, uint8_t& g, uint8_t& b) {
+    uint8_t r5 = c >> 11, g6 = (c >> 5) & 0x3F, b5 = c & 0x1F;
+    r = (uint8_t)((r5 << 3) | (r5 >> 2));
+    g = (uint8_t)((g6 << 2) | (g6 >> 4));
+    b = (uint8_t)((b5 << 3) | (b5 >> 2));
+  }
+
+  static void put32be(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)(v >> 24);
+    p[1] = (uint8_t)(v >> 16);
+    p[2] = (uint8_t)(v >> 8);
+    p[3] = (uint8_t)v;
+  }
+
+  static void put32le(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+  }
+
+  int bmpStride() const { return (width * 3 + 3) & ~3; }
+
+  // zlib hlavička + bloky + Adler-32
+  uint32_t idatLength() const {
+    return 2 + (uint32_t)height * (5 + 1 + width * 3) + 4;
+  }
+
+  void adler(const uint8_t* p, size_t len) {
+    // řádek (max 961 B) se do přetečení 32 bitů vejde, modulo stačí jednou
+    for (size_t i = 0; i < len; i++) {
+      adlerA += p[i];
+      adlerB += adlerA;
+    }
+    adlerA %= 65521;
+    adlerB %= 65521;
+  }
+
+  size_t bmpHeader(uint8_t* out) {
+    memset(out, 0, 54);
+    out[0] = 'B';
+    out[1] = 'M';
+    put32le(out + 2, totalSize());
+    put32le(out + 10, 54);              // začátek pixelů
+    put32le(out + 14, 40);              // BITMAPINFOHEADER
+    put32le(out + 18, (uint32_t)width);
+    put32le(out + 22, (uint32_t)height);
+    out[26] = 1;                        // roviny
+    out[28] = 24;                       // bitů na pixel
+    put32le(out + 34, (uint32_t)bmpStride() * height);
+    put32le(out + 38, 2835);            // 72 dpi
+    put32le(out + 42, 2835);
+    return 54;
+  }
+
+  size_t pngHeader(uint8_t* out) {
+    static const uint8_t SIG[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    size_t n = 0;
+    memcpy(out, SIG, 8);
+    n += 8;
+
+    // IHDR
+    put32be(out + n, 13);
+    memcpy(out + n + 4, "IHDR", 4);
+    uint8_t* d = out + n + 8;
+    put32be(d, (uint32_t)width);
+    put32be(d + 4, (uint32_t)height);
+    d[8]  = 8;    // bit depth
+    d[9]  = 2;    // truecolor RGB
+    d[10] = 0;    // deflate
+    d[11] = 0;    // filtry
+    d[12] = 0;    // bez prokládání
+    put32be(out + n + 21, crc32(0, out + n + 4, 17));
+    n += 25;
+
+    // začátek IDAT – CRC počítá typ chunku i všechna data
+    put32be(out + n, idatLength());
+    memcpy(out + n + 4, "IDAT", 4);
+    out[n + 8] = 0x78;   // zlib: deflate, okno 32K
+    out[n + 9] = 0x01;   // bez slovníku, nejrychlejší úroveň (FCHECK)
+    crc = crc32(0, out + n + 4, 6);
+    n += 10;
+    return n;
+  }
+
+  ScreenFormat format = SE_BMP;
+  int      width    = 0;
+  int      height   = 0;
+  int      rowsDone = 0;
+  uint32_t crc      = 0;
+  uint32_t adlerA   = 1;
+  uint32_t adlerB   = 0;
+};
@@ -0,0 +1,217 @@
+#pragma once
+
+// ========================
+// Binární stream vzorků přes UDP
+// ========================
+// Čistý C++ bez Arduino závislostí – firmware pakety skládá, host nástroj
+// tools/udprecv.cpp je čte. Vše little endian, bez zarovnání (čte se po
+// bajtech, takže nezáleží na překladači ani architektuře).
+//
+// Datagram = hlavička (24 B) + count vzorků:
+//   u16 magic "SW"   u8 version   u8 cells
+//   u32 bootId       náhodné při startu; změna = zařízení restartovalo
+//   u32 seq          pořadové číslo prvního vzorku v paketu
+//   u64 baseTimeUs   čas prvního vzorku (esp_timer)
+//   u8  count        vzorků v paketu
+//   u8  flags        SP_RESYNC = první paket po startu / změně konfigurace
+//   u16 reserved
+// Vzorek (9 + 3 * cells B):
+//   u32 dtUs         od baseTimeUs
+//   i32 mg           vyfiltrovaná hmotnost v miligramech
+//   u8  flags        SS_STABLE, SS_DYNAMIC, SS_HELD
+//   i24 raw[cells]   surové HX711 (24 bit se znaménkem)
+//
+// Ztráty: seq čísluje vzorky (ne pakety), takže příjemce z mezery mezi
+// očekávaným a přijatým seq přesně ví, kolik vzorků chybí. Při změně
+// bootId nebo příznaku SP_RESYNC se počítání začne znovu bez hlášení ztráty.
+
+#include <stdint.h>
+#include <stddef.h>
+
+const uint16_t STREAM_MAGIC       = 0x5753;   // "SW"
+const uint8_t  STREAM_VERSION     = 1;
+const int      STREAM_HEADER_SIZE = 24;
+const int      STREAM_MAX_CELLS   = 8;
+const int      STREAM_MAX_BATCH   = 32;       // 24 + 32 * 33 B < 1472 (jeden Ethernet rámec)
+const int      STREAM_MAX_PACKET  = STREAM_HEADER_SIZE + STREAM_MAX_BATCH * (9 + 3 * STREAM_MAX_CELLS);
+
+// příznaky paketu
+const uint8_t SP_RESYNC = 0x01;
+
+// příznaky vzorku
+const uint8_t SS_STABLE  = 0x01;
+const uint8_t SS_DYNAMIC = 0x02;
+const uint8_t SS_HELD    = 0x04;
+
+struct StreamHeader {
+  uint8_t  version;
+  uint8_t  cells;
+  uint32_t bootId;
+  uint32_t seq;
+  uint64_t baseTimeUs;
+  uint8_t  count;
+  uint8_t  flags;
+};
+
+struct StreamSample {
+  uint32_t seq;
+  uint64_t tUs;
+  int32_t  mg;
+  uint8_t  flags;
+  int32_t  raw[STREAM_MAX_CELLS];
+};
+
+inline int streamSampleSize(int cells) {
+  return 9 + 3 * cells;
+}
+
+// ---- zápis ----
+
+// skládá vzorky do paketu; push() vrací true, když je paket plný a má se odeslat
+class StreamWriter {
+public:
+  void begin(uint32_t bootId_, int cells_, int batch_) {
+    bootId = bootId_;
+    cells  = cells_ < 1 ? 1 : (cells_ > STREAM_MAX_CELLS ? STREAM_MAX_CELLS : cells_);
+    batch  = batch_ < 1 ? 1 : (batch_ > STREAM_MAX_BATCH ? STREAM_MAX_BATCH : batch_);
+    count  = 0;
+    len    = STREAM_HEADER_SIZE;
+    resync = true;
+  }
+
+  // další paket ponese SP_RESYNC (např. po změně konfigurace)
+  void markResync() { resync = true; }
+
+  bool push(uint64_t tUs, int32_t mg, uint8_t flags, const long* raw) {
+    if (count == 0) {
+      firstSeq  = seq;
+      firstTime = tUs;
+    }
+    put32(buf + len, (uint32_t)(tUs - firstTime));
+    put32(buf + len + 4, (uint32_t)mg);
+    buf[len + 8] = flags;
+    len += 9;
+    for (int i = 0; i < cells; i++) {
+      uint32_t r = (uint32_t)raw[i];
+      buf[len++] = (uint8_t)r;
+      buf[len++] = (uint8_t)(r >> 8);
+      buf[len++] = (uint8_t)(r >> 16);
+    }
+    count++;
+    seq++;
+    return count >= batch;
+  }
+
+  int pending() const { return count; }
+  uint64_t pendingSinceUs() const { return firstTime; }
+  uint32_t nextSeq() const { return seq; }
+
+  // dokončí hlavičku; platí do dalšího push()
+  const uint8_t* finish(size_t& outLen) {
+    uint8_t* h = buf;
+    h[0] = (uint8_t)STREAM_MAGIC;
+    h[1] = (uint8_t)(STREAM_MAGIC >> 8);
+    h[2] = STREAM_VERSION;
+    h[3] = (uint8_t)cells;
+    put32(h + 4, bootId);
+    put32(h + 8, firstSeq);
+    put32(h + 12, (uint32_t)firstTime);
+    put32(h + 16, (uint32_t)(firstTime >> 32));
+    h[20] = (uint8_t)count;
+    h[21] = resync ? SP_RESYNC : 0;
+    h[22] = 0;
+    h[23] = 0;
+
+    outLen = len;
+    resync = false;
+    count  = 0;
+    len    = STREAM_HEADER_SIZE;
+    return buf;
+  }
+
+private:
+  static void put32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+  }
+
+  uint8_t  buf[STREAM_MAX_PACKET];
+  size_t   len       = STREAM_HEADER_SIZE;
+  uint32_t bootId    = 0;
+  uint32_t seq       = 0;
+  uint32_t firstSeq  = 0;
+  uint64_t firstTime = 0;
+  int      cells     = 1;
+  int      batch     = 1;
+  int      count     = 0;
+  bool     resync    = true;
+};
+
+// ---- čtení ----
+
+inline uint32_t streamGet32(const uint8_t* p) {
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// ověří a rozbalí hlavičku; false = není to náš paket nebo je useknutý
+inline bool streamParseHeader(const uint8_t* p, size_t len, StreamHeader& h) {
+  if (len < (size_t)STREAM_HEADER_SIZE) return false;
+  if ((p[0] | (p[1] << 8)) != STREAM_MAGIC || p[2] != STREAM_VERSION) return false;
+  h.version    = p[2];
+  h.cells      = p[3];
+  h.bootId     = streamGet32(p + 4);
+  h.seq        = streamGet32(p + 8);
+  h.baseTimeUs = streamGet32(p + 12) | ((uint64_t)streamGet32(p + 16) << 32);
+  h.count      = p[20];
+  h.flags      = p[21];
+  if (h.cells < 1 || h.cells > STREAM_MAX_CELLS) return false;
+  return len >= (size_t)(STREAM_HEADER_SIZE + h.count * streamSampleSize(h.cells));
+}
+
+// i-tý vzorek paketu (hlavička musí být ověřená přes streamParseHeader)
+inline void streamGetSample(const uint8_t* p, const StreamHeader& h, int i, StreamSample& s) {
+  const uint8_t* q = p + STREAM_HEADER_SIZE + i * streamSampleSize(h.cells);
+  s.seq   = h.seq + i;
+  s.tUs   = h.baseTimeUs + streamGet32(q);
+  s.mg    = (int32_t)streamGet32(q + 4);
+  s.flags = q[8];
+  q += 9;
+  for (int c = 0; c < h.cells; c++, q += 3) {
+    uint32_t r = q[0] | (q[1] << 8) | ((uint32_t)q[2] << 16);
+    s.raw[c] = (r & 0x800000) ? (int32_t)(r | 0xFF000000u) : (int32_t)r;
+  }
+}
+
+// sledování ztrát na straně příjemce
+struct StreamLossTracker {
+  bool     synced    = false;
+  uint32_t bootId    = 0;
+  uint32_t expected  = 0;     // seq dalšího očekávaného vzorku
+  uint64_t received  = 0;     // vzorků
+  uint64_t lost      = 0;     // vzorků v mezerách
+  uint64_t late      = 0;     // vzorků starších než expected (přeházené / duplicitní)
+  uint32_t resyncs   = 0;
+
+  // vrací počet vzorků, které před tímto paketem chybí
+  uint32_t feed(const StreamHeader& h) {
+    uint32_t gap = 0;
+    if (!synced || h.bootId != bootId || (h.flags & SP_RESYNC)) {
+      if (synced) resyncs++;
+      synced = true;
+      bootId = h.bootId;
+    } else {
+      int32_t d = (int32_t)(h.seq - expected);
+      if (d < 0) {
+        late += h.count;
+        return 0;               // expected se neposouvá
+      }
+      gap = (uint32_t)d;
+      lost += gap;
+    }
+    expected  = h.seq + h.count;
+    received += h.count;
+    return gap;
+  }
+};
@@ -0,0 +1,212 @@
+#pragma once
+
+// ========================
+// Zpracování váhy: surové HX711 -> gramy
+// ========================
+// Čistý C++ bez Arduino závislostí. Na ESP32 z toho vzniká currentWeight,
+// host nástroj tools/replay.cpp jím prohání nahrané záznamy – obě strany
+// tak počítají přesně stejně.
+//
+// Kroky: (raw - tara) / kalibrace pro každý článek -> součet zón a celku
+// -> klouzavý průměr -> detekce ustálení -> odečtení nádoby.
+//
+// Všechno v celých miligramech (int32, mezivýpočty int64). Kalibrace se
+// drží jako float "jednotek na gram" (tak je uložená v NVS), ale pro výpočet
+// se jednou převede na násobitel mg/jednotku v pevné řádové čárce
+// (SCALE_SHIFT bitů za čárkou) – na vzorek tak jen násobení a posun.
+// Zobrazení i JSON jdou přes wpFormatMg(), takže všude stejné zaokrouhlení.
+//
+// Vadný článek nebo nesmyslná kalibrace nesmí nic přetočit: mg každého
+// článku se nasytí na ±WP_LIMIT_MG, součty jdou v int64 a nasytí se až na
+// konci. Polovina rozsahu int32 – rozdíl dvou hodnot (drift, minus nádoba)
+// se tak do int32 vejde vždy a INT32_MIN zůstane volný pro "žádná hodnota".
+
+#include <stdint.h>
+#include <math.h>
+
+const int WP_MAX_CELLS  = 8;
+const int WP_MAX_ZONES  = 4;
+const int WP_MAX_FILTER = 32;
+
+const int32_t WP_LIMIT_MG = INT32_MAX / 2;   // ~1073 kg
+
+inline int32_t wpClampMg(int64_t mg) {
+  if (mg > WP_LIMIT_MG)  return WP_LIMIT_MG;
+  if (mg < -WP_LIMIT_MG) return -WP_LIMIT_MG;
+  return (int32_t)mg;
+}
+
+// mg zaokrouhlené na 'decimals' desetinných míst gramu (0..3), půlky od nuly
+inline int32_t wpRoundMg(int32_t mg, int decimals) {
+  static const int32_t STEP[4] = { 1000, 100, 10, 1 };
+  int32_t step = STEP[decimals < 0 ? 0 : (decimals > 3 ? 3 : decimals)];
+  int32_t half = step / 2;
+  int32_t q = mg >= 0 ? (mg + half) / step : -((-mg + half) / step);
+  return q * step;
+}
+
+// mg -> "-12.3" (gramy, 'decimals' míst); buf aspoň 16 B, vrací délku
+inline int wpFormatMg(int32_t mg, int decimals, char* buf) {
+  if (decimals < 0) decimals = 0;
+  if (decimals > 3) decimals = 3;
+  int32_t r = wpRoundMg(mg, decimals);
+  uint32_t a = r < 0 ? (uint32_t)0 - (uint32_t)r : (uint32_t)r;
+
+  char tmp[16];
+  int n = 0;
+  uint32_t frac = a % 1000;
+  for (int i = 3; i > decimals; i--) frac /= 10;
+  for (int i = 0; i < decimals; i++) {
+    tmp[n++] = (char)('0' + frac % 10);
+    frac /= 10;
+  }
+  if (decimals > 0) tmp[n++] = '.';
+  uint32_t whole = a / 1000;
+  do {
+    tmp[n++] = (char)('0' + whole % 10);
+    whole /= 10;
+  } while (whole);
+  if (r < 0) tmp[n++] = '-';
+
+  for (int i = 0; i < n; i++) buf[i] = tmp[n - 1 - i];
+  buf[n] = 0;
+  return n;
+}
+
+inline int32_t wpGramsToMg(float grams) {
+  return (int32_t)lroundf(grams * 1000.0f);
+}
+
+class WeightPipeline {
+public:
+  static const int SCALE_SHIFT = 24;   // bitů za čárkou v cellMul
+
+  // konfigurace
+  int   cellCount = 1;
+  int   zoneCount = 1;
+  int   cellZone[WP_MAX_CELLS]   = {0};
+  long  cellOffset[WP_MAX_CELLS] = {0};   // tara (surové jednotky)
+  float cellScale[WP_MAX_CELLS];          // kalibrace – jednotek na gram, měnit přes setCellScale()
+
+  int      filterLength      = 1;        // klouzavý průměr přes N vzorků (1 = bez filtru), měnit přes setFilterLength()
+  int32_t  stableThresholdMg = 1000;     // o kolik se smí hodnota hnout
+  uint32_t stableTimeUs      = 500000;   // jak dlouho musí vydržet v toleranci
+  int32_t  containerTareMg   = 0;        // hmotnost nádoby, odečte se až na výstupu
+
+  // výstup posledního vzorku (mg)
+  int32_t cellMg[WP_MAX_CELLS] = {0};
+  int32_t zoneMg[WP_MAX_ZONES] = {0};
+  int32_t rawTotalMg = 0;              // součet před filtrem
+  int32_t grossMg    = 0;              // po filtru, včetně nádoby
+  int32_t totalMg    = 0;              // gross - nádoba
+  bool    stable     = false;
+
+  WeightPipeline() {
+    for (int i = 0; i < WP_MAX_CELLS; i++) setCellScale(i, 1.0f);
+  }
+
+  // cellScale nastavené přímo se převezme tady
+  void begin(int cells, int zones) {
+    cellCount = cells;
+    zoneCount = zones;
+    for (int i = 0; i < WP_MAX_CELLS; i++) setCellScale(i, cellScale[i]);
+    resetFilter();
+  }
+
+  void setCellScale(int cell, float unitsPerGram) {
+    if (unitsPerGram == 0.0f || !isfinite(unitsPerGram)) unitsPerGram = 1.0f;
+    cellScale[cell] = unitsPerGram;
+    // nesmyslně malá kalibrace by přetočila llround – strop, výstup se pak nasytí
+    double mul = 1000.0 * (double)(1LL << SCALE_SHIFT) / unitsPerGram;
+    if (mul > 1e18)  mul = 1e18;
+    if (mul < -1e18) mul = -1e18;
+    cellMul[cell]   = llround(mul);
+  }
+
+  void setFilterLength(int n) {
+    if (n < 1) n = 1;
+    if (n > WP_MAX_FILTER) n = WP_MAX_FILTER;
+    filterLength = n;
+    resetFilter();
+  }
+
+  // nádoba se projeví hned, bez čekání na další vzorek / ustálení
+  void setContainerTare(int32_t mg) {
+    containerTareMg = mg;
+    totalMg = wpClampMg((int64_t)grossMg - containerTareMg);
+  }
+
+  void resetFilter() {
+    filterCount = 0;
+    filterHead  = 0;
+    filterSum   = 0;
+    stable      = false;
+    stableRefMg = 0;
+    stableSinceUs = 0;
+    haveRef     = false;
+  }
+
+  // jeden vzorek ze všech článků; tUs = čas vzorku v mikrosekundách
+  void process(const long* raw, uint64_t tUs) {
+    int64_t zoneSum[WP_MAX_ZONES] = {0};
+    int64_t total = 0;
+    for (int i = 0; i < cellCount; i++) {
+      cellMg[i] = scaleMg((int64_t)raw[i] - cellOffset[i], cellMul[i]);
+      zoneSum[cellZone[i]] += cellMg[i];
+      total += cellMg[i];
+    }
+    for (int z = 0; z < zoneCount; z++) zoneMg[z] = wpClampMg(zoneSum[z]);
+    int32_t sum = wpClampMg(total);
+    rawTotalMg = sum;
+
+    // klouzavý průměr
+    int len = filterLength;
+    if (filterCount >= len) {
+      filterSum -= filterBuf[(filterHead + WP_MAX_FILTER - len) % WP_MAX_FILTER];
+    } else {
+      filterCount++;
+    }
+    filterBuf[filterHead] = sum;
+    filterHead = (filterHead + 1) % WP_MAX_FILTER;
+    filterSum += sum;
+    int64_t h = filterCount / 2;
+    grossMg = (int32_t)(filterSum >= 0 ? (filterSum + h) / filterCount : (filterSum - h) / filterCount);
+
+    // ustálení – hodnota se drží v toleranci kolem kotvy dost dlouho;
+    // počítá se z gross, aby změna nádoby neshodila "stable"
+    int32_t drift = grossMg - stableRefMg;
+    if (!haveRef || drift > stableThresholdMg || -drift > stableThresholdMg) {
+      stableRefMg   = grossMg;
+      stableSinceUs = tUs;
+      haveRef       = true;
+      stable        = false;
+    } else if (tUs - stableSinceUs >= stableTimeUs) {
+      stable = true;
+    }
+
+    totalMg = wpClampMg((int64_t)grossMg - containerTareMg);
+  }
+
+private:
+  // surové jednotky * násobitel -> mg, nasycené; součin se kontroluje
+  // předem, ať nepřeteče ani int64 (extrémní kalibrace)
+  static int32_t scaleMg(int64_t units, int64_t mul) {
+    uint64_t au = units < 0 ? (uint64_t)0 - (uint64_t)units : (uint64_t)units;
+    uint64_t am = mul < 0 ? (uint64_t)0 - (uint64_t)mul : (uint64_t)mul;
+    const uint64_t lim = (uint64_t)WP_LIMIT_MG << SCALE_SHIFT;
+    if (am != 0 && au > lim / am) return (units < 0) != (mul < 0) ? -WP_LIMIT_MG : WP_LIMIT_MG;
+    int64_t v = units * mul;
+    return wpClampMg((v + (1LL << (SCALE_SHIFT - 1))) >> SCALE_SHIFT);
+  }
+
+  int64_t cellMul[WP_MAX_CELLS];        // mg na jednotku << SCALE_SHIFT
+
+  int32_t filterBuf[WP_MAX_FILTER];
+  int     filterCount = 0;
+  int     filterHead  = 0;
+  int64_t filterSum   = 0;
+
+  int32_t  stableRefMg   = 0;
+  uint64_t stableSinceUs = 0;
+  bool     haveRef       = false;
+};
@@ -3,13 +3,33 @@
 #include <WebServer.h>
 #include <ESPmDNS.h>
 #include <WiFiManager.h>      // konfigurační portal
+#include <PubSubClient.h>     // MQTT
+#include <WiFiUdp.h>
 
 #include <SPI.h>
 #include <Adafruit_GFX.h>
 #include <Adafruit_ST7789.h>
 
-#include "HX711.h"
+#include <Preferences.h>
 #include <time.h>
+#include <sys/time.h>
+#include <esp_sntp.h>
+
+#include <LittleFS.h>
+#include <esp_timer.h>
+#include <esp_partition.h>
+#include <lwip/sockets.h>    // neblokující connect pro flotilu
+#include <errno.h>
+
+#include "dynamic_weigh.h"
+#include "checkweigh.h"
+#include "piece_count.h"
+#include "recipe.h"
+#include "screen_encode.h"
+#include "input_logic.h"
+#include "weight_pipeline.h"
+#include "food_db.h"
+#include "stream_proto.h"
 
 // ========================
 // PINY
@@ -30,37 +50,210 @@ const int TFT_DC   = 7;
 // HX711 – použijeme piny, co máš napsané jako I2C
 const int HX711_DOUT = 8;   // "SDA"
 const int HX711_SCK  = 9;   // "SCL"
+// RATE pin HX711 (LOW = 10 SPS, HIGH = 80 SPS); -1 = napevno na desce
+const int HX711_RATE = -1;
+
+// ========================
+// Tenzometry (víc HX711)
+// ========================
+// Každý článek má vlastní HX711 a vlastní DOUT. SCK může být sdílený –
+// všechny převodníky se čtou paralelně stejnými hodinovými pulzy, takže
+// další článek nesnižuje vzorkovací frekvenci jednotlivých kanálů.
+// zone = do které vážící zóny se článek počítá (např. dva zásobníky).
+struct LoadCellConfig {
+  int dout;
+  int sck;
+  int zone;
+};
+
+const int LOAD_CELL_COUNT = 1;
+const LoadCellConfig LOAD_CELLS[LOAD_CELL_COUNT] = {
+  { HX711_DOUT, HX711_SCK, 0 },
+  // plošina se 4 články – další DOUT na stejném SCK:
+  // { 18, HX711_SCK, 0 },
+  // { 21, HX711_SCK, 0 },
+  // { 47, HX711_SCK, 0 },
+};
+const int ZONE_COUNT = 1;
 
 // ========================
 // Web server
 // ========================
 WebServer server(80);
 
+// identita zařízení – "vaha-xxxxxx" z konce MAC (MQTT, discovery)
+char deviceId[16];
+
 // ========================
 // Váha / stav
 // ========================
-float currentWeight = 0.0f;
+int32_t currentWeightMg = 0;  // součet všech článků po filtru a nádobě (mg)
 String currentItem  = "Nic";
 
+// jediné zaokrouhlení váhy pro HUD, JSON i MQTT (wpFormatMg)
+const int WEIGHT_DECIMALS = 1;
+const int32_t WEIGHT_NONE = INT32_MIN;   // "ještě nevykresleno"
+
+// váha do JSONu / MQTT – stejné zaokrouhlení jako na displeji
+String weightText(int32_t mg) {
+  char buf[16];
+  wpFormatMg(mg, WEIGHT_DECIMALS, buf);
+  return String(buf);
+}
+
+// text do JSON řetězce (bez uvozovek okolo); dst se vždy ukončí, co se
+// nevejde, se usekne po celých znacích
+void jsonEscape(char* dst, size_t len, const char* src) {
+  size_t j = 0;
+  for (; *src; src++) {
+    char c = *src;
+    char esc[8];
+    int  n;
+    if (c == '"' || c == '\\')  n = snprintf(esc, sizeof(esc), "\\%c", c);
+    else if (c == '\n')         n = snprintf(esc, sizeof(esc), "\\n");
+    else if ((uint8_t)c < 0x20) n = snprintf(esc, sizeof(esc), "\\u%04x", (unsigned)(uint8_t)c);
+    else { esc[0] = c; esc[1] = 0; n = 1; }
+    if (j + n >= len) break;
+    memcpy(dst + j, esc, n);
+    j += n;
+  }
+  dst[j] = 0;
+}
+
+String jsonText(const String& s) {
+  String out;
+  out.reserve(s.length() + 8);
+  char buf[8];
+  char one[2] = { 0, 0 };
+  for (size_t i = 0; i < s.length(); i++) {
+    one[0] = s[i];
+    jsonEscape(buf, sizeof(buf), one);
+    out += buf;
+  }
+  return out;
+}
+
+// verze stavu pro cache HTTP odpovědí – zvýšit při každé změně, kterou
+// ukazuje /api/state (váha, ustálení, položka, nádoba, režim, kalibrace)
+uint32_t stateVersion = 0;
+int32_t  versionWeightMg = WEIGHT_NONE;
+bool     versionStable = false;
+int      versionDynState = -1;
+int      versionCount = 0;
+
+// jednotlivé kanály
+long  cellRaw[LOAD_CELL_COUNT];                  // poslední surové čtení
+uint64_t cellRawTimeUs = 0;                      // kdy bylo čtení (esp_timer)
+
+// tara, kalibrace, filtr a ustálení – sdílené s host nástroji (tools/replay.cpp)
+WeightPipeline weighing;
+static_assert(LOAD_CELL_COUNT <= WP_MAX_CELLS, "moc clanku");
+static_assert(ZONE_COUNT <= WP_MAX_ZONES, "moc zon");
+
+// různé SCK piny (sdílený SCK je v seznamu jen jednou)
+int sckPins[LOAD_CELL_COUNT];
+int sckPinCount = 0;
+
+Preferences prefs;
+
+// dynamické vážení – preset "Zvíře"
+DynamicWeigher dynWeigher;
+bool dynamicMode = false;
+
+// kontrolní vážení balíčků (/api/check)
+CheckWeigher checkWeigher;
+bool checkMode = false;
+
+// počítání kusů (z menu)
+PieceCounter pieceCounter;
+bool countMode = false;
+
+// recept nahraný přes /api/recipe
+RecipeRunner recipe;
+bool recipeMode = false;
+
 // ========================
 // LCD a váha objekty
 // ========================
-Adafruit_ST7789 tft(TFT_CS, TFT_DC, TFT_RST);
-HX711 scale;
+// ST7789 se stínovým bufferem v PSRAM: každé kreslení jde i do kopie
+// obrazovky (RGB565, logické souřadnice po rotaci), ze které se dá
+// kdykoli udělat snímek (/api/screenshot) – z displeje se číst nedá.
+// Adafruit_GFX všechno (text, rámečky, kruhy) skládá z těchto primitiv.
+class ShadowST7789 : public Adafruit_ST7789 {
+public:
+  ShadowST7789(int cs, int dc, int rst) : Adafruit_ST7789(cs, dc, rst) {}
+
+  // po init(); bez PSRAM zůstane bez stínu (snímky pak nejdou)
+  bool beginShadow() {
+    if (!shadow) shadow = (uint16_t*)ps_malloc(SHADOW_PIXELS * sizeof(uint16_t));
+    if (shadow) memset(shadow, 0, SHADOW_PIXELS * sizeof(uint16_t));
+    return shadow != nullptr;
+  }
+
+  bool hasShadow() const { return shadow != nullptr; }
+
+  // řádek y v aktuální rotaci (width() pixelů)
+  const uint16_t* shadowRow(int y) const { return shadow + y * width(); }
+
+  void drawPixel(int16_t x, int16_t y, uint16_t c) override {
+    shadowFill(x, y, 1, 1, c);
+    Adafruit_ST7789::drawPixel(x, y, c);
+  }
+  void writePixel(int16_t x, int16_t y, uint16_t c) override {
+    shadowFill(x, y, 1, 1, c);
+    Adafruit_ST7789::writePixel(x, y, c);
+  }
+  void writeFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t c) override {
+    shadowFill(x, y, w, h, c);
+    Adafruit_ST7789::writeFillRect(x, y, w, h, c);
+  }
+  void writeFastHLine(int16_t x, int16_t y, int16_t w, uint16_t c) override {
+    shadowFill(x, y, w, 1, c);
+    Adafruit_ST7789::writeFastHLine(x, y, w, c);
+  }
+  void writeFastVLine(int16_t x, int16_t y, int16_t h, uint16_t c) override {
+    shadowFill(x, y, 1, h, c);
+    Adafruit_ST7789::writeFastVLine(x, y, h, c);
+  }
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t c) override {
+    shadowFill(x, y, w, h, c);
+    Adafruit_ST7789::fillRect(x, y, w, h, c);
+  }
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t c) override {
+    shadowFill(x, y, w, 1, c);
+    Adafruit_ST7789::drawFastHLine(x, y, w, c);
+  }
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t c) override {
+    shadowFill(x, y, 1, h, c);
+    Adafruit_ST7789::drawFastVLine(x, y, h, c);
+  }
+
+private:
+  static const int SHADOW_PIXELS = 320 * 240;
+
+  void shadowFill(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t c) {
+    if (!shadow) return;
+    int x0 = x < 0 ? 0 : x, y0 = y < 0 ? 0 : y;
+    int x1 = x + w > width() ? width() : x + w;
+    int y1 = y + h > height() ? height() : y + h;
+    for (int yy = y0; yy < y1; yy++) {
+      uint16_t* p = shadow + yy * width();
+      for (int xx = x0; xx < x1; xx++) p[xx] = c;
+    }
+  }
+
+  uint16_t* shadow = nullptr;
+};
+
+ShadowST7789 tft(TFT_CS, TFT_DC, TFT_RST);
 
 // ========================
-// Rotary enkoder stav
+// Rotary enkoder a tlačítko – stav
 // ========================
-long encoderPosition = 0;
-int  lastEncA        = HIGH;
-bool lastButtonState = HIGH;
-unsigned long lastButtonEventMs = 0;
-
-// dlouhý stisk
-const unsigned long LONG_PRESS_MS = 1500;
-unsigned long buttonPressStartMs  = 0;
-bool buttonLongPressEvent         = false;
-bool buttonLongPressFired        = false;  // aby se long press nevytvářel víckrát během jednoho stisku
+// logika je v include/input_logic.h, tady se jen krmí piny a millis()
+EncoderDecoder    encoder;      // pozice, rychlost, akcelerace
+ButtonDecoder     button;       // debounce 30 ms, dlouhý stisk 1500 ms
+HudEncoderGesture hudGesture;   // ±5 kroků v HUD -> menu, 2 s bez pohybu = od nuly
 
 
 // ========================
@@ -70,60 +263,82 @@ enum UiMode {
   UI_HUD = 0,
   UI_MENU = 1,
   UI_MENU_TARE = 2,
-  UI_MENU2 = 3
+  UI_MENU2 = 3,
+  UI_MENU_COUNT = 4
 };
 
 UiMode uiMode = UI_HUD;
 
 // menu (hlavní)
-const int MENU_ITEMS = 3;
+const int MENU_ITEMS = 4;
 const char* MENU_LABELS[MENU_ITEMS] = {
   "Kalibrace",
   "Resetovat WiFi",
+  "Pocitani kusu",
   "Zpet"
 };
 
-int  menuIndex    = 0;
-long menuEncStart = 0;   // encoder position při vstupu do menu
+// menu počítání kusů: 0 = Zpet, pak velikosti vzorku, poslední = Ukoncit
+const int COUNT_REF_OPTIONS = 5;
+const int COUNT_REF_PIECES[COUNT_REF_OPTIONS] = { 5, 10, 20, 50, 100 };
 
-// menu TARE (misky/hrnky)
-const int MENU_TARE_ITEMS = 6;
-const char* MENU_TARE_LABELS[MENU_TARE_ITEMS] = {
-  "Zpet",
-  "Mala miska plastova",
-  "Maly hrnecek",
-  "Velky hrnek",
-  "melky talir 1",
-  "melky talir 2"
-};
+// menu TARE (misky/hrnky) – položky se skládají z tabulky nádob:
+//   0 = Zpet, 1 = Bez nadoby, 2.. = nádoby, poslední = + Nova nadoba
+// menu2 = potraviny z databáze v abecedním pořadí, 0 = Zpet
 
-int menuTareIndex = 0;
-
-// menu2 placeholder
-const int MENU2_ITEMS = 6;
-const char* MENU2_LABELS[MENU2_ITEMS] = {
-  "Zpet",
-  "menu item 1",
-  "menu item 2",
-  "menu item 3",
-  "menu item 4",
-  "menu item 5"
+// ========================
+// Seznamy (menu)
+// ========================
+// Společný seznam pro všechna menu. Enkodér se bere relativně a s akcelerací,
+// kreslí se s pevným rozpočtem řádků na průchod loopu – při rychlém točení se
+// mezistavy přeskočí a dokreslí se jen to, co je na displeji opravdu jinak.
+const int LIST_ROWS       = 7;   // řádků na displeji (y 40..206)
+const int LIST_ROW_BUDGET = 2;   // max překreslených řádků za jeden průchod
+
+// count / index / top a jejich hlídání jsou v ListCursor (input_logic.h)
+struct ListView : ListCursor {
+  uint16_t accent;
+  void (*label)(int index, char* buf, size_t len);
+  bool (*marked)(int index);                 // aktivní položka (může být nullptr)
+  int  (*jump)(int index, int dir);          // typeahead skok (může být nullptr)
+  long encLast;                              // pozice enkodéru při posledním kroku
+  int  drawnItem[LIST_ROWS];                 // co je nakreslené ve slotu (-2 = neplatné)
+  bool drawnSel[LIST_ROWS];
+  int  drawnTop;                             // pro posuvník
 };
 
-int menu2Index = 0;
-
-// baseline enkodéru pro HUD (pro detekci ±5 kroků)
-long hudEncStart = 0;
-unsigned long lastHudEncoderMoveMs = 0;
-long hudEncLastPos = 0;
+ListView mainMenu;
+ListView tareMenu;   // MENU_TARE – nádoby
+ListView foodMenu;   // MENU2 – potraviny
+ListView countMenu;  // MENU_COUNT – počítání kusů
 
 // ========================
 // HUD – poslední vykreslené hodnoty
 // ========================
-float lastDrawnWeight = 999999.0f;
+int32_t lastDrawnWeightMg = WEIGHT_NONE;   // zaokrouhleno na WEIGHT_DECIMALS
+int32_t lastDrawnZoneMg[ZONE_COUNT];
+int   lastDrawnContainer = -2;
+int   lastDrawnDynState = -1;
 int   lastWifiLevel   = -1;
-String lastTimeStr    = "";
-String lastDateStr    = "";
+uint32_t lastDrawnClock = UINT32_MAX;
+long  lastDrawnEnc      = 0;
+int   lastDrawnBtn      = -1;
+unsigned long lastRssiMs = 0;
+
+// kontrolní vážení – verdikt se kreslí jednou na kus
+uint32_t lastDrawnCheckTotal = UINT32_MAX;
+int      lastDrawnCheckState = -1;
+unsigned long lastCheckStatsMs = 0;
+bool     hudRedrawPending    = false;   // změna z HTTP – loop zavolá enterHudMode()
+
+// recept
+int  lastDrawnRecipeStep = -1;
+int  lastDrawnRecipeBar  = -1;     // px pruhu aktuálního kroku
+
+// počítání kusů
+int  lastDrawnCountState = -1;
+int  lastDrawnCount      = 0;
+bool lastDrawnCountOk    = false;
 
 // TAR stav
 bool tarActive        = false;
@@ -144,34 +359,331 @@ uint16_t COLOR_MENU2_ACCENT     = 0xFFE0; // žlutá
 // ========================
 // Čas – NTP
 // ========================
+// Hodiny tiká esp_timer jednou za sekundu (těsně po přelomu sekundy)
+// a rovnou připraví text do pevných bufferů. HUD a API jen porovnají
+// clockVersion – formátuje se jednou za sekundu, bez String na heapu,
+// a nikdy se nečeká na NTP (getLocalTime() umí blokovat až 5 s).
 const long  gmtOffset_sec     = 3600;   // +1h
 const int   daylightOffset_sec = 3600;  // další hodina v létě
 
-bool getLocalTimeSafe(struct tm * timeinfo) {
-  if (!getLocalTime(timeinfo)) {
-    return false;
+const time_t CLOCK_VALID_EPOCH = 1600000000;   // dřív = čas ještě není nastavený
+
+struct ClockText {
+  char time[9];     // HH:MM:SS
+  char date[11];    // YYYY-MM-DD
+};
+
+ClockText clockText = { "--:--:--", "----/--/--" };
+volatile uint32_t clockVersion      = 0;   // +1 při každé změně textu
+volatile bool     clockSynced       = false;
+volatile uint32_t clockSyncCount    = 0;
+volatile time_t   clockLastSync     = 0;   // epoch poslední NTP synchronizace
+volatile int32_t  clockCorrectionMs = 0;   // o kolik NTP posunul hodiny naposledy
+volatile int32_t  clockUtcOffset    = 0;   // s, včetně letního času
+static portMUX_TYPE clockMux = portMUX_INITIALIZER_UNLOCKED;
+esp_timer_handle_t clockTimer = nullptr;
+
+// odhad času mezi synchronizacemi (pro clockCorrectionMs)
+int64_t clockRefEpochUs = 0;
+int64_t clockRefMonoUs  = 0;
+
+void clockArm() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  esp_timer_start_once(clockTimer, 1000000 - tv.tv_usec + 2000);
+}
+
+// běží v tasku esp_timer
+void clockTick(void*) {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+
+  ClockText t = { "--:--:--", "----/--/--" };
+  if (tv.tv_sec >= CLOCK_VALID_EPOCH) {
+    struct tm tm;
+    time_t sec = tv.tv_sec;
+    localtime_r(&sec, &tm);
+    strftime(t.time, sizeof(t.time), "%H:%M:%S", &tm);
+    strftime(t.date, sizeof(t.date), "%Y-%m-%d", &tm);
+    clockUtcOffset = gmtOffset_sec + (tm.tm_isdst > 0 ? daylightOffset_sec : 0);
   }
-  return true;
+
+  portENTER_CRITICAL(&clockMux);
+  if (strcmp(t.time, clockText.time) != 0 || strcmp(t.date, clockText.date) != 0) {
+    clockText = t;
+    clockVersion++;
+  }
+  clockRefEpochUs = (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+  clockRefMonoUs  = esp_timer_get_time();
+  portEXIT_CRITICAL(&clockMux);
+
+  clockArm();
+}
+
+// volá SNTP po nastavení času (task lwIP)
+void clockOnSync(struct timeval* tv) {
+  int64_t nowUs = (int64_t)tv->tv_sec * 1000000 + tv->tv_usec;
+
+  portENTER_CRITICAL(&clockMux);
+  int64_t predicted = clockRefEpochUs + (esp_timer_get_time() - clockRefMonoUs);
+  portEXIT_CRITICAL(&clockMux);
+
+  // první synchronizace posouvá z 1970 – to není korekce
+  clockCorrectionMs = clockSynced ? (int32_t)((nowUs - predicted) / 1000) : 0;
+  clockLastSync     = tv->tv_sec;
+  clockSynced       = true;
+  clockSyncCount++;
+
+  // nový čas ukázat hned, ne až za sekundu
+  esp_timer_stop(clockTimer);
+  esp_timer_start_once(clockTimer, 1000);
+}
+
+void setupClock() {
+  esp_timer_create_args_t args = {};
+  args.callback = clockTick;
+  args.name     = "clock";
+  esp_timer_create(&args, &clockTimer);
+  sntp_set_time_sync_notification_cb(clockOnSync);
+  clockArm();
 }
 
-String getTimeString() {
-  struct tm timeinfo;
-  if (!getLocalTimeSafe(&timeinfo)) {
-    return "--:--:--";
+// kopie textu; vrací verzi – stejná verze = není co překreslovat
+uint32_t clockRead(ClockText& out) {
+  portENTER_CRITICAL(&clockMux);
+  out = clockText;
+  uint32_t v = clockVersion;
+  portEXIT_CRITICAL(&clockMux);
+  return v;
+}
+
+// unix čas, nebo 0 když ještě není nastavený
+uint32_t clockEpoch() {
+  time_t t = time(nullptr);
+  return t >= CLOCK_VALID_EPOCH ? (uint32_t)t : 0;
+}
+
+// ========================
+// Watchdog smyčky (zaseknutí)
+// ========================
+// Loop a vybrané tasky posílají heartbeat. Hlídací task každých 100 ms
+// zkontroluje, jestli některý nepřekročil svůj limit; pokud ano, uloží
+// záznam: který task, v jaké fázi (zásobník fází = logický "backtrace",
+// skutečný zásobník cizího tasku za běhu přečíst nejde), jak dlouho a stav
+// heapu. Záznamy jsou v RTC paměti (RTC_NOINIT) – přežijí reset včetně
+// pádu a panicu, smaže je jen odpojení napájení.
+//
+// Fáze se značí RAII objektem: { WdStage st(WD_LOOP, ST_HTTP); ... }
+enum WdStageId : uint8_t {
+  ST_NONE = 0,
+  ST_HTTP,
+  ST_SCALE,
+  ST_HUD,
+  ST_MENU,
+  ST_FS,
+  ST_UDP,
+  ST_MQTT_CONNECT,
+  ST_MQTT_PUBLISH,
+  ST_COUNT
+};
+
+const char* WD_STAGE_NAMES[ST_COUNT] = {
+  "-", "http", "scale", "hud", "menu", "fs", "udp", "mqtt_connect", "mqtt_publish"
+};
+
+const int WD_MAX_TASKS   = 4;
+const int WD_STACK_DEPTH = 6;
+const int WD_RECORDS     = 16;
+const unsigned long WD_CHECK_MS = 100;
+
+struct WdTask {
+  const char*       name;
+  uint32_t          limitMs;
+  volatile uint32_t lastBeatMs;
+  volatile uint8_t  depth;
+  volatile uint8_t  stack[WD_STACK_DEPTH];
+  int               openRecord;     // index záznamu právě trvajícího zaseknutí, -1 = žádné
+};
+
+// záznam v RTC paměti – jen POD, žádné ukazatele
+struct WdRecord {
+  uint32_t boot;            // pořadí startu (rtcBootCount)
+  uint32_t uptimeMs;        // kdy se zaseknutí zjistilo
+  uint32_t durationMs;      // průběžně se aktualizuje, dokud trvá
+  uint32_t freeHeap;
+  uint32_t minFreeHeap;
+  uint32_t maxAllocHeap;
+  char     task[12];
+  uint8_t  stack[WD_STACK_DEPTH];
+  uint8_t  depth;
+  uint8_t  ongoing;         // 1 = ještě neskončilo (po resetu = skončilo resetem)
+};
+
+struct WdRing {
+  uint32_t magic;
+  uint32_t bootCount;
+  uint32_t head;
+  uint32_t count;
+  WdRecord rec[WD_RECORDS];
+};
+
+const uint32_t WD_RING_MAGIC = 0x57445231;   // "WDR1"
+
+RTC_NOINIT_ATTR WdRing wdRing;
+WdTask wdTasks[WD_MAX_TASKS];
+int    wdTaskCount = 0;
+int    WD_LOOP = -1;
+esp_reset_reason_t wdResetReason = ESP_RST_UNKNOWN;
+static portMUX_TYPE wdMux = portMUX_INITIALIZER_UNLOCKED;
+
+// volá se z tasku, který se má hlídat (nebo ze setup() za loop)
+int wdRegister(const char* name, uint32_t limitMs) {
+  portENTER_CRITICAL(&wdMux);
+  int id = wdTaskCount < WD_MAX_TASKS ? wdTaskCount : -1;
+  if (id >= 0) {
+    WdTask& t = wdTasks[id];
+    t.name       = name;
+    t.limitMs    = limitMs;
+    t.lastBeatMs = millis();
+    t.depth      = 0;
+    t.openRecord = -1;
+    wdTaskCount++;
   }
-  char buf[9];
-  strftime(buf, sizeof(buf), "%H:%M:%S", &timeinfo);
-  return String(buf);
+  portEXIT_CRITICAL(&wdMux);
+  return id;
+}
+
+inline void wdBeat(int id) {
+  if (id >= 0) wdTasks[id].lastBeatMs = millis();
+}
+
+inline void wdPush(int id, uint8_t stage) {
+  if (id < 0) return;
+  WdTask& t = wdTasks[id];
+  if (t.depth < WD_STACK_DEPTH) t.stack[t.depth] = stage;
+  t.depth++;
+}
+
+inline void wdPop(int id) {
+  if (id >= 0 && wdTasks[id].depth > 0) wdTasks[id].depth--;
+}
+
+struct WdStage {
+  int id;
+  WdStage(int id_, uint8_t stage) : id(id_) { wdPush(id, stage); }
+  ~WdStage() { wdPop(id); }
+};
+
+// "http>scale"
+void wdStackString(const uint8_t* stack, uint8_t depth, char* buf, size_t len) {
+  size_t n = 0;
+  buf[0] = 0;
+  if (depth == 0) {
+    strlcpy(buf, "idle", len);
+    return;
+  }
+  for (int i = 0; i < depth && i < WD_STACK_DEPTH; i++) {
+    uint8_t st = stack[i] < ST_COUNT ? stack[i] : ST_NONE;
+    n += snprintf(buf + n, n < len ? len - n : 0, i ? ">%s" : "%s", WD_STAGE_NAMES[st]);
+  }
+  if (depth > WD_STACK_DEPTH && n < len) snprintf(buf + n, len - n, ">...");
+}
+
+void wdPrintRecord(const WdRecord& r) {
+  char stack[64];
+  wdStackString(r.stack, r.depth, stack, sizeof(stack));
+  Serial.printf("[WD] boot %u  +%lu ms  %s stal %lu ms%s  faze %s  heap %u (min %u, blok %u)\n",
+                (unsigned)r.boot, (unsigned long)r.uptimeMs, r.task, (unsigned long)r.durationMs,
+                r.ongoing ? (r.boot == wdRing.bootCount ? " (trva)" : " (skoncilo resetem)") : "",
+                stack, (unsigned)r.freeHeap, (unsigned)r.minFreeHeap, (unsigned)r.maxAllocHeap);
 }
 
-String getDateString() {
-  struct tm timeinfo;
-  if (!getLocalTimeSafe(&timeinfo)) {
-    return "----/--/--";
+// běží ve vlastním tasku
+void wdCheck() {
+  for (int i = 0; i < wdTaskCount; i++) {
+    WdTask& t = wdTasks[i];
+    // heartbeat jednou a až pak millis() – naopak by beat z jiného jádra
+    // mezi čteními dal now < last a rozdíl přetečený na falešné zaseknutí
+    uint32_t last   = t.lastBeatMs;
+    uint32_t now    = millis();
+    int32_t  silent = (int32_t)(now - last);
+
+    if (silent > (int32_t)t.limitMs) {
+      if (t.openRecord < 0) {
+        // nové zaseknutí – snímek fází teď, dokud ještě platí
+        WdRecord r;
+        memset(&r, 0, sizeof(r));
+        r.boot         = wdRing.bootCount;
+        r.uptimeMs     = last;
+        r.durationMs   = (uint32_t)silent;
+        r.freeHeap     = ESP.getFreeHeap();
+        r.minFreeHeap  = ESP.getMinFreeHeap();
+        r.maxAllocHeap = ESP.getMaxAllocHeap();
+        strlcpy(r.task, t.name, sizeof(r.task));
+        r.depth = t.depth;
+        for (int k = 0; k < WD_STACK_DEPTH; k++) r.stack[k] = t.stack[k];
+        r.ongoing = 1;
+
+        portENTER_CRITICAL(&wdMux);
+        int idx = wdRing.head;
+        wdRing.rec[idx] = r;
+        wdRing.head = (wdRing.head + 1) % WD_RECORDS;
+        if (wdRing.count < WD_RECORDS) wdRing.count++;
+        portEXIT_CRITICAL(&wdMux);
+
+        t.openRecord = idx;
+        wdPrintRecord(r);
+      } else {
+        wdRing.rec[t.openRecord].durationMs = (uint32_t)silent;
+      }
+    } else if (t.openRecord >= 0) {
+      // rozběhlo se – doba až do posledního heartbeatu
+      WdRecord& r = wdRing.rec[t.openRecord];
+      r.durationMs = last - r.uptimeMs;
+      r.ongoing    = 0;
+      t.openRecord = -1;
+      Serial.printf("[WD] %s zase bezi po %lu ms\n", t.name, (unsigned long)r.durationMs);
+    }
   }
-  char buf[11];
-  strftime(buf, sizeof(buf), "%Y-%m-%d", &timeinfo);
-  return String(buf);
+}
+
+void wdTask(void*) {
+  for (;;) {
+    wdCheck();
+    vTaskDelay(pdMS_TO_TICKS(WD_CHECK_MS));
+  }
+}
+
+void wdClear() {
+  portENTER_CRITICAL(&wdMux);
+  wdRing.head  = 0;
+  wdRing.count = 0;
+  for (int i = 0; i < wdTaskCount; i++) wdTasks[i].openRecord = -1;
+  portEXIT_CRITICAL(&wdMux);
+}
+
+// volá se hned na začátku setup(); výpis záznamů z minulých běhů
+void setupWatchdog() {
+  wdResetReason = esp_reset_reason();
+  if (wdRing.magic != WD_RING_MAGIC || wdRing.head >= WD_RECORDS || wdRing.count > WD_RECORDS ||
+      wdResetReason == ESP_RST_POWERON) {
+    memset(&wdRing, 0, sizeof(wdRing));
+    wdRing.magic = WD_RING_MAGIC;
+  }
+  wdRing.bootCount++;
+
+  Serial.printf("[WD] start %u, reset reason %d, %u zaznamu\n",
+                (unsigned)wdRing.bootCount, (int)wdResetReason, (unsigned)wdRing.count);
+  for (uint32_t i = 0; i < wdRing.count; i++) {
+    wdPrintRecord(wdRing.rec[(wdRing.head + WD_RECORDS - wdRing.count + i) % WD_RECORDS]);
+  }
+
+}
+
+// na konci setup() – konfigurační portál WiFi a tara před tím smí trvat
+void startWatchdog() {
+  WD_LOOP = wdRegister("loop", 1500);
+  xTaskCreatePinnedToCore(wdTask, "wd", 3072, nullptr, 2, nullptr, 0);
 }
 
 // ========================
@@ -311,6 +823,7 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
       </div>
       <div style="font-size:0.9rem; opacity:0.8; margin-top:4px;">
         Položka: <span id="itemLabel">Nic</span>
+        <span id="kcalLabel"></span>
       </div>
     </div>
 
@@ -345,8 +858,15 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
         const res = await fetch('/api/state');
         if (!res.ok) return;
         const data = await res.json();
-        document.getElementById('weightValue').textContent = data.weight.toFixed(2);
+        const held = data.dynamic && data.dynamic.active && data.dynamic.state !== 'empty';
+        document.getElementById('weightValue').textContent = (held ? data.dynamic.value : data.weight).toFixed(1);
         document.getElementById('itemLabel').textContent = data.item || 'Nic';
+        document.getElementById('kcalLabel').textContent = data.food ? '(' + data.food.kcal.toFixed(0) + ' kcal)' : '';
+        if (data.recipe && data.recipe.active) {
+          document.getElementById('kcalLabel').textContent = data.recipe.finished ? '(recept hotov)' :
+            '(krok ' + data.recipe.step + '/' + data.recipe.steps + ': ' + data.recipe.name + ' ' +
+            data.recipe.current.toFixed(1) + ' / ' + data.recipe.target.toFixed(1) + ' g)';
+        }
         document.getElementById('lastUpdate').textContent = 'Naposledy: ' + new Date().toLocaleTimeString();
         document.getElementById('rssiLabel').textContent = 'RSSI: ' + (data.rssi ?? '--') + ' dBm';
         document.getElementById('connectionStatus').textContent = 'WiFi OK';
@@ -385,228 +905,2908 @@ const char INDEX_HTML[] PROGMEM = R"rawliteral(
 )rawliteral";
 
 // ========================
-// Váha
+// HTML – přehled všech vah v síti (/fleet)
 // ========================
-void updateWeightFromScale() {
-  if (scale.is_ready()) {
-    currentWeight = scale.get_units(1);  // bez kalibrace
-  }
-}
+// Jedna stránka, jedno dotazování (/api/fleet) – ostatní váhy obchází
+// tahle váha sama a drží jejich poslední stav v cache.
+const char FLEET_HTML[] PROGMEM = R"rawliteral(
+<!DOCTYPE html>
+<html lang="cs">
+<head>
+  <meta charset="UTF-8">
+  <title>Váhy v síti</title>
+  <meta name="viewport" content="width=device-width, initial-scale=1.0">
+  <style>
+    :root {
+      font-family: system-ui, -apple-system, BlinkMacSystemFont, "Segoe UI", sans-serif;
+      color-scheme: dark light;
+    }
+    body {
+      margin: 0;
+      padding: 16px;
+      background: #05070b;
+      color: #f5f5f5;
+    }
+    h1 {
+      font-size: 1.3rem;
+      margin: 0 0 12px;
+    }
+    .grid {
+      display: grid;
+      grid-template-columns: repeat(auto-fill, minmax(220px, 1fr));
+      gap: 12px;
+    }
+    .card {
+      background: radial-gradient(circle at top, #1b2840, #05070b);
+      border-radius: 14px;
+      padding: 14px 16px;
+      border: 1px solid rgba(255,255,255,0.06);
+    }
+    .card.off { opacity: 0.45; }
+    .card a { color: #6fb3ff; text-decoration: none; font-size: 0.85rem; }
+    .weight { font-size: 2rem; font-weight: 600; margin: 6px 0; }
+    .meta { font-size: 0.75rem; color: #9aa4b5; }
+  </style>
+</head>
+<body>
+  <h1>Váhy v síti <span class="meta" id="status"></span></h1>
+  <div class="grid" id="grid"></div>
 
-// ========================
-// Rotary enkoder
-// ========================
-void updateEncoder() {
-  int a = digitalRead(ENC_A);
-  int b = digitalRead(ENC_B);
+  <script>
+    function card(s, host, ok, note) {
+      const d = document.createElement('div');
+      d.className = 'card' + (ok ? '' : ' off');
+      const a = document.createElement('a');
+      a.href = 'http://' + host + '/';
+      a.textContent = host;
+      const w = document.createElement('div');
+      w.className = 'weight';
+      w.textContent = s ? s.weight.toFixed(1) + ' g' + (s.stable ? '' : ' ~') : '--';
+      const m = document.createElement('div');
+      m.className = 'meta';
+      m.textContent = s ? (s.item + ' | ' + s.mode + (note ? ' | ' + note : '')) : note;
+      d.append(a, w, m);
+      return d;
+    }
 
-  if (a != lastEncA) {
-    if (a == HIGH) {
-      if (b == LOW) encoderPosition++;
-      else          encoderPosition--;
+    async function fetchFleet() {
+      try {
+        const res = await fetch('/api/fleet');
+        if (!res.ok) return;
+        const f = await res.json();
+        const grid = document.getElementById('grid');
+        grid.replaceChildren(card(f.self, f.self.host, true, 'tato vaha'));
+        for (const p of f.peers) {
+          const note = p.ok ? p.latency_ms + ' ms' : 'nedostupna ' + Math.round(p.age_ms / 1000) + ' s';
+          grid.append(card(p.summary, p.host, p.ok, note));
+        }
+        document.getElementById('status').textContent =
+          (f.peers.length + 1) + ' vah, sken pred ' + Math.round(f.scan_age_ms / 1000) + ' s';
+      } catch (e) {
+        document.getElementById('status').textContent = 'Chyba spojeni...';
+      }
     }
-    lastEncA = a;
-  }
-}
+
+    fetchFleet();
+    setInterval(fetchFleet, 2000);
+  </script>
+</body>
+</html>
+)rawliteral";
 
 // ========================
-// Button – detekce krátkého stisku
+// Váha
 // ========================
-bool checkButtonClicked() {
-  bool cur = digitalRead(ENC_SW);
-  unsigned long now = millis();
-  bool clicked = false;
+static portMUX_TYPE hx711Mux = portMUX_INITIALIZER_UNLOCKED;
 
-  if (cur != lastButtonState) {
-    // jednoduchý debounce
-    if (now - lastButtonEventMs > 30) {
-      lastButtonEventMs = now;
+void setupLoadCells() {
+  sckPinCount = 0;
+  for (int i = 0; i < LOAD_CELL_COUNT; i++) {
+    pinMode(LOAD_CELLS[i].dout, INPUT);
 
-      // hrana dolů = začátek stisku
-      if (lastButtonState == HIGH && cur == LOW) {
-        buttonPressStartMs   = now;
-        buttonLongPressFired = false;
-      }
-      // hrana nahoru = konec stisku
-      else if (lastButtonState == LOW && cur == HIGH) {
-        unsigned long pressDuration = now - buttonPressStartMs;
-        // pokud jsme ještě nevystřelili long press, bereme to jako krátký klik
-        if (!buttonLongPressFired && pressDuration < LONG_PRESS_MS) {
-          clicked = true;
-        }
-        // když už long press proběhl, po puštění se nic dalšího neděje
-      }
+    bool known = false;
+    for (int j = 0; j < sckPinCount; j++) {
+      if (sckPins[j] == LOAD_CELLS[i].sck) known = true;
+    }
+    if (!known) {
+      sckPins[sckPinCount++] = LOAD_CELLS[i].sck;
+      pinMode(LOAD_CELLS[i].sck, OUTPUT);
+      digitalWrite(LOAD_CELLS[i].sck, LOW);
+    }
+
+    cellRaw[i] = 0;
+    weighing.cellZone[i]   = LOAD_CELLS[i].zone;
+    weighing.cellOffset[i] = 0;
+    weighing.setCellScale(i, 1.0f);  // bez kalibrace
+  }
+  weighing.begin(LOAD_CELL_COUNT, ZONE_COUNT);
+}
+
+// HX711 má data připravená, když drží DOUT v LOW
+bool loadCellsReady() {
+  for (int i = 0; i < LOAD_CELL_COUNT; i++) {
+    if (digitalRead(LOAD_CELLS[i].dout) != LOW) return false;
+  }
+  return true;
+}
 
-      lastButtonState = cur;
+// přečte všechny články najednou – jeden hodinový pulz posune bit ve všech HX711
+void readLoadCellsParallel(long* out) {
+  uint32_t values[LOAD_CELL_COUNT] = {0};
+
+  // SCK nesmí zůstat v HIGH přes 60 us (HX711 by usnul) -> bez přerušení
+  portENTER_CRITICAL(&hx711Mux);
+  for (int bit = 0; bit < 24; bit++) {
+    for (int j = 0; j < sckPinCount; j++) digitalWrite(sckPins[j], HIGH);
+    delayMicroseconds(1);
+    for (int i = 0; i < LOAD_CELL_COUNT; i++) {
+      values[i] = (values[i] << 1) | (digitalRead(LOAD_CELLS[i].dout) == HIGH ? 1 : 0);
     }
+    for (int j = 0; j < sckPinCount; j++) digitalWrite(sckPins[j], LOW);
+    delayMicroseconds(1);
   }
+  // 25. pulz = příští převod kanál A, zisk 128
+  for (int j = 0; j < sckPinCount; j++) digitalWrite(sckPins[j], HIGH);
+  delayMicroseconds(1);
+  for (int j = 0; j < sckPinCount; j++) digitalWrite(sckPins[j], LOW);
+  delayMicroseconds(1);
+  portEXIT_CRITICAL(&hx711Mux);
+
+  for (int i = 0; i < LOAD_CELL_COUNT; i++) {
+    // 24bit dvojkový doplněk -> long
+    if (values[i] & 0x800000UL) values[i] |= 0xFF000000UL;
+    out[i] = (int32_t)values[i];
+  }
+}
 
-  // long press detekujeme během držení (tlačítko je LOW)
-  if (lastButtonState == LOW && !buttonLongPressFired) {
-    unsigned long pressDuration = now - buttonPressStartMs;
-    if (pressDuration >= LONG_PRESS_MS) {
-      buttonLongPressEvent = true;
-      buttonLongPressFired = true;
+// tara všech článků – průměr z několika čtení
+void tareLoadCells(int samples) {
+  long long sum[LOAD_CELL_COUNT] = {0};
+  long raw[LOAD_CELL_COUNT];
+  int got = 0;
+  unsigned long start = millis();
+
+  while (got < samples && millis() - start < 2000) {
+    if (!loadCellsReady()) {
+      delay(1);
+      continue;
     }
+    readLoadCellsParallel(raw);
+    for (int i = 0; i < LOAD_CELL_COUNT; i++) sum[i] += raw[i];
+    got++;
   }
 
-  return clicked;
+  if (got == 0) {
+    Serial.println("[HX711] tara selhala – zadna data");
+    return;
+  }
+  for (int i = 0; i < LOAD_CELL_COUNT; i++) {
+    weighing.cellOffset[i] = (long)(sum[i] / got);
+  }
+  weighing.resetFilter();
+  stateVersion++;
+}
+
+// kalibrace článků v NVS ("cal0", "cal1", ...)
+void loadCellCalibration() {
+  prefs.begin("vaha", true);
+  for (int i = 0; i < LOAD_CELL_COUNT; i++) {
+    char key[8];
+    snprintf(key, sizeof(key), "cal%d", i);
+    weighing.setCellScale(i, prefs.getFloat(key, 1.0f));   // 0 / nesmysl -> 1.0
+  }
+  prefs.end();
+}
+
+void saveCellCalibration(int cell) {
+  char key[8];
+  snprintf(key, sizeof(key), "cal%d", cell);
+  prefs.begin("vaha", false);
+  prefs.putFloat(key, weighing.cellScale[cell]);
+  prefs.end();
+  stateVersion++;
 }
 
 // ========================
-// HUD – statická část
+// Záznam surových dat (trace)
 // ========================
-void drawTopBarGradient() {
-  // jednoduchý vertikální "glow" gradient
-  for (int y = 0; y < 24; y++) {
-    uint8_t mix = map(y, 0, 23, 0, 255);
-    uint8_t r1 = (COLOR_TOPBAR1 >> 11) & 0x1F;
-    uint8_t g1 = (COLOR_TOPBAR1 >> 5)  & 0x3F;
-    uint8_t b1 = (COLOR_TOPBAR1)       & 0x1F;
+// Formát (CSV, stejný pro sériovou linku i soubor):
+//   # smart_scale trace v1
+//   # cells=N zones=Z
+//   # zone=..  offset=..  scale=..   (po článcích, odděleno čárkou)
+//   # filter=.. stable_g=.. stable_us=.. container_mg=..
+//   t_us,raw0,raw1,...
+// Host nástroj tools/replay.cpp z hlavičky převezme konfiguraci pipeline.
+//
+// Soubor má rozpočet: nejvýš TRACE_MAX_BYTES a na LittleFS musí zůstat
+// TRACE_FS_RESERVE pro konfiguraci a ostatní zápisy. Po vyčerpání nebo při
+// chybě zápisu se záznam sám ukončí (soubor končí celým řádkem).
+enum TraceDest {
+  TRACE_OFF    = 0,
+  TRACE_SERIAL = 1,
+  TRACE_FILE   = 2
+};
 
-    uint8_t r2 = (COLOR_TOPBAR2 >> 11) & 0x1F;
-    uint8_t g2 = (COLOR_TOPBAR2 >> 5)  & 0x3F;
-    uint8_t b2 = (COLOR_TOPBAR2)       & 0x1F;
+const char*    TRACE_FILE_PATH  = "/trace.csv";
+const uint32_t TRACE_MAX_BYTES  = 1024 * 1024;
+const uint32_t TRACE_FS_RESERVE = 64 * 1024;
+const uint32_t TRACE_MIN_BYTES  = 4096;        // míň místa -> ani nezačínat
+
+TraceDest traceDest = TRACE_OFF;
+File      traceFile;
+uint64_t  traceEndUs   = 0;     // 0 = bez limitu
+uint32_t  traceSamples = 0;
+char      traceBuf[1024];       // do souboru zapisujeme po blocích
+size_t    traceBufLen  = 0;
+uint32_t  traceBytes   = 0;     // už zapsáno do souboru
+uint32_t  traceBudget  = 0;     // víc se do souboru nezapíše
+
+// blok do souboru; false = rozpočet vyčerpaný nebo zápis selhal
+bool traceFlush() {
+  if (traceBufLen == 0) return true;
+  if (traceBytes + traceBufLen > traceBudget) {
+    traceBufLen = 0;
+    return false;
+  }
+  WdStage st(WD_LOOP, ST_FS);
+  size_t written = traceFile.write((const uint8_t*)traceBuf, traceBufLen);
+  traceBytes += written;
+  bool ok = written == traceBufLen;
+  traceBufLen = 0;
+  return ok;
+}
 
-    uint8_t r = (r1 * (255 - mix) + r2 * mix) / 255;
-    uint8_t g = (g1 * (255 - mix) + g2 * mix) / 255;
-    uint8_t b = (b1 * (255 - mix) + b2 * mix) / 255;
+bool traceWrite(const char* data, size_t len) {
+  if (traceDest == TRACE_SERIAL) {
+    Serial.write((const uint8_t*)data, len);
+    return true;
+  }
+  if (traceBufLen + len > sizeof(traceBuf) && !traceFlush()) return false;
+  memcpy(traceBuf + traceBufLen, data, len);
+  traceBufLen += len;
+  return true;
+}
 
-    uint16_t c = (r << 11) | (g << 5) | b;
-    tft.drawFastHLine(0, y, 320, c);
+void traceWriteHeader() {
+  char line[160];
+  int n;
+
+  n = snprintf(line, sizeof(line), "# smart_scale trace v1\n# cells=%d zones=%d\n# zone=",
+               LOAD_CELL_COUNT, ZONE_COUNT);
+  traceWrite(line, n);
+  for (int i = 0; i < LOAD_CELL_COUNT; i++) {
+    n = snprintf(line, sizeof(line), i ? ",%d" : "%d", weighing.cellZone[i]);
+    traceWrite(line, n);
   }
+  traceWrite("\n# offset=", 10);
+  for (int i = 0; i < LOAD_CELL_COUNT; i++) {
+    n = snprintf(line, sizeof(line), i ? ",%ld" : "%ld", weighing.cellOffset[i]);
+    traceWrite(line, n);
+  }
+  traceWrite("\n# scale=", 9);
+  for (int i = 0; i < LOAD_CELL_COUNT; i++) {
+    n = snprintf(line, sizeof(line), i ? ",%.6f" : "%.6f", weighing.cellScale[i]);
+    traceWrite(line, n);
+  }
+  n = snprintf(line, sizeof(line), "\n# filter=%d stable_g=%.3f stable_us=%u container_mg=%ld\nt_us",
+               weighing.filterLength, weighing.stableThresholdMg / 1000.0, (unsigned)weighing.stableTimeUs,
+               (long)weighing.containerTareMg);
+  traceWrite(line, n);
+  for (int i = 0; i < LOAD_CELL_COUNT; i++) {
+    n = snprintf(line, sizeof(line), ",raw%d", i);
+    traceWrite(line, n);
+  }
+  traceWrite("\n", 1);
 }
 
-void drawStaticHUD() {
-  tft.fillScreen(COLOR_BG);
+bool traceStart(TraceDest dest, uint32_t seconds) {
+  if (traceDest != TRACE_OFF) return false;
 
-  // top bar
-  drawTopBarGradient();
+  if (dest == TRACE_FILE) {
+    traceFile = LittleFS.open(TRACE_FILE_PATH, "w");
+    if (!traceFile) {
+      Serial.println("[TRACE] nelze otevrit soubor");
+      return false;
+    }
+    // volné místo až po zkrácení starého záznamu
+    size_t total = LittleFS.totalBytes();
+    size_t used  = LittleFS.usedBytes();
+    size_t avail = total > used + TRACE_FS_RESERVE ? total - used - TRACE_FS_RESERVE : 0;
+    traceBudget = avail < TRACE_MAX_BYTES ? (uint32_t)avail : TRACE_MAX_BYTES;
+    if (traceBudget < TRACE_MIN_BYTES) {
+      traceFile.close();
+      Serial.printf("[TRACE] malo mista na LittleFS (%u B volno)\n", (unsigned)(total - used));
+      return false;
+    }
+  }
+  traceDest    = dest;
+  traceSamples = 0;
+  traceBufLen  = 0;
+  traceBytes   = 0;
+  traceEndUs   = seconds ? esp_timer_get_time() + (uint64_t)seconds * 1000000ULL : 0;
+  traceWriteHeader();
+  return true;
+}
 
-  // "Chytra vaha" label vlevo nahoře
-  tft.setTextColor(COLOR_TEXT);
-  tft.setTextSize(1);
-  tft.setCursor(4, 6);
-  tft.print("Chytra vaha");
+void traceStop() {
+  if (traceDest == TRACE_OFF) return;
 
-  int boxX = 20;
-  int boxY = 60;
-  int boxW = 280;
-  int boxH = 120;
+  if (traceDest == TRACE_FILE) {
+    traceFlush();
+    traceFile.close();
+  }
+  traceBufLen = 0;
+  traceDest   = TRACE_OFF;
+  Serial.printf("\n[TRACE] konec, %u vzorku\n", (unsigned)traceSamples);
+}
 
-  uint16_t glowColor = COLOR_TOPBAR2;
-  tft.fillRoundRect(boxX - 4, boxY - 4, boxW + 8, boxH + 8, 14, glowColor);
-  tft.fillRoundRect(boxX, boxY, boxW, boxH, 12, COLOR_BG);
+// volá se pro každý nový vzorek z HX711
+void traceSample() {
+  if (traceDest == TRACE_OFF) return;
 
-  // label "g"
-  tft.setTextSize(2);
-  tft.setCursor(boxX + boxW - 35, boxY + boxH - 28);
-  tft.setTextColor(COLOR_ACCENT);
-  tft.print("g");
+  char line[16 + LOAD_CELL_COUNT * 12];
+  int n = snprintf(line, sizeof(line), "%llu", (unsigned long long)cellRawTimeUs);
+  for (int i = 0; i < LOAD_CELL_COUNT; i++) {
+    n += snprintf(line + n, sizeof(line) - n, ",%ld", cellRaw[i]);
+  }
+  line[n++] = '\n';
+  if (!traceWrite(line, n)) {
+    Serial.printf("\n[TRACE] soubor plny nebo chyba zapisu (%u B)\n", (unsigned)traceBytes);
+    traceStop();
+    return;
+  }
+  traceSamples++;
 
-  // spodní status bar (enkoder / stav tlačítka)
-  tft.drawFastHLine(0, 220, 320, COLOR_TOPBAR2);
+  if (traceEndUs && cellRawTimeUs >= traceEndUs) {
+    traceStop();
+  }
 }
 
-void eraseWeightArea() {
-  // smažeme jen oblast, kde je číslo
-  int boxX = 20;
+// ========================
+// UDP stream vzorků
+// ========================
+// Pro loggery, kterým JSON nestačí: každý vzorek z HX711 (až 80 SPS) jde
+// binárně po UDP, K vzorků v jednom datagramu. Formát a detekce ztrát viz
+// include/stream_proto.h, příjemce tools/udprecv.cpp. Cíl může být unicast
+// i multicast adresa (224.0.0.0/4).
+struct StreamConfig {
+  bool      enabled;
+  IPAddress host;
+  uint16_t  port;
+  uint8_t   batch;            // vzorků v datagramu
+};
+
+const uint32_t STREAM_MAX_AGE_US = 250000;   // neúplný paket se pošle nejpozději po 250 ms
+
+StreamConfig streamCfg;
+StreamWriter streamWriter;
+WiFiUDP      streamUdp;
+uint32_t     streamBootId   = 0;
+uint32_t     streamPackets  = 0;
+uint32_t     streamSendErrs = 0;
+
+void loadStreamConfig() {
+  prefs.begin("udp", true);
+  streamCfg.enabled = prefs.getBool("on", false);
+  streamCfg.host.fromString(prefs.getString("host", "239.1.2.3"));
+  streamCfg.port  = prefs.getUShort("port", 5005);
+  streamCfg.batch = prefs.getUChar("batch", 8);
+  prefs.end();
+
+  streamWriter.begin(streamBootId, LOAD_CELL_COUNT, streamCfg.batch);
+}
+
+void saveStreamConfig() {
+  prefs.begin("udp", false);
+  prefs.putBool("on", streamCfg.enabled);
+  prefs.putString("host", streamCfg.host.toString());
+  prefs.putUShort("port", streamCfg.port);
+  prefs.putUChar("batch", streamCfg.batch);
+  prefs.end();
+}
+
+void streamSend() {
+  WdStage st(WD_LOOP, ST_UDP);
+  size_t len;
+  const uint8_t* pkt = streamWriter.finish(len);
+  if (WiFi.status() != WL_CONNECTED) {
+    streamSendErrs++;
+    return;
+  }
+  // UDP send jen předá paket lwIP – neblokuje na síti
+  if (!streamUdp.beginPacket(streamCfg.host, streamCfg.port) ||
+      streamUdp.write(pkt, len) != len ||
+      !streamUdp.endPacket()) {
+    streamSendErrs++;
+    return;
+  }
+  streamPackets++;
+}
+
+// volá se pro každý nový vzorek z HX711
+void streamSample() {
+  if (!streamCfg.enabled) return;
+
+  uint8_t flags = 0;
+  if (weighing.stable) flags |= SS_STABLE;
+  if (dynamicMode) {
+    flags |= SS_DYNAMIC;
+    if (dynWeigher.getState() == DW_HELD) flags |= SS_HELD;
+  }
+  bool full = streamWriter.push(cellRawTimeUs, currentWeightMg, flags, cellRaw);
+  if (full || cellRawTimeUs - streamWriter.pendingSinceUs() >= STREAM_MAX_AGE_US) {
+    streamSend();
+  }
+}
+
+void setupStream() {
+  streamBootId = esp_random();
+  loadStreamConfig();
+}
+
+// ========================
+// Trend – historie váhy pro graf
+// ========================
+// Kruhový buffer sloupců pod rámečkem váhy: sloupec = min/max filtrované
+// váhy za TREND_COLUMN_MS. Graf se kreslí "zametáním" jako na osciloskopu –
+// nový sloupec přepíše nejstarší na stejném místě, takže nový vzorek stojí
+// zápis jednoho sloupce místo překreslení celého grafu. (Hardwarový scroll
+// ST7789 posouvá jen podél 320 px osy panelu, v landscape tedy svisle.)
+// Celý graf se překreslí jen při změně rozsahu (auto-range).
+const int TREND_X = 20;
+const int TREND_Y = 189;
+const int TREND_W = 280;                       // sloupců = px
+const int TREND_H = 28;
+const unsigned long TREND_SECONDS   = 28;      // šířka grafu v čase
+const unsigned long TREND_COLUMN_MS = TREND_SECONDS * 1000 / TREND_W;
+const int32_t TREND_MIN_SPAN_MG = 2000;        // menší rozsah by ukazoval jen šum
+
+struct TrendColumn {
+  int32_t lo, hi;     // mg
+  bool  stable;
+  bool  valid;        // false = v tom čase nepřišel žádný vzorek
+};
+
+TrendColumn trendCols[TREND_W];
+int   trendHead    = 0;       // kam přijde další sloupec
+int   trendPending = 0;       // hotové, ale ještě nenakreslené sloupce
+int   trendSinceRescale = 0;
+bool  trendFullRedraw = true;
+int32_t trendLo = 0, trendHi = TREND_MIN_SPAN_MG;   // zobrazený rozsah (mg)
+
+// rozpracovaný sloupec
+int32_t trendAccLo = 0, trendAccHi = 0;
+bool  trendAccStable = true;
+bool  trendAccAny    = false;
+unsigned long trendColStartMs = 0;
+
+// rozsah podle obsahu bufferu, s okrajem a minimální šířkou
+void trendRescale() {
+  int32_t lo = 0, hi = 0;
+  bool any = false;
+  for (int i = 0; i < TREND_W; i++) {
+    if (!trendCols[i].valid) continue;
+    if (!any || trendCols[i].lo < lo) lo = trendCols[i].lo;
+    if (!any || trendCols[i].hi > hi) hi = trendCols[i].hi;
+    any = true;
+  }
+  if (!any) return;
+
+  int32_t minSpan = max(TREND_MIN_SPAN_MG, 4 * weighing.stableThresholdMg);
+  int32_t pad = (hi - lo) / 7;   // ~15 % rezerva, ať se při sypání nepřekresluje každý sloupec
+  lo -= pad;
+  hi += pad;
+  if (hi - lo < minSpan) {
+    int32_t mid = lo + (hi - lo) / 2;
+    lo = mid - minSpan / 2;
+    hi = mid + minSpan / 2;
+  }
+  trendLo = lo;
+  trendHi = hi;
+  trendSinceRescale = 0;
+  trendFullRedraw   = true;
+}
+
+void trendCommitColumn() {
+  TrendColumn& c = trendCols[trendHead];
+  c.valid  = trendAccAny;
+  c.lo     = trendAccLo;
+  c.hi     = trendAccHi;
+  c.stable = trendAccStable;
+  trendHead = (trendHead + 1) % TREND_W;
+  if (trendPending < TREND_W) trendPending++;
+  trendAccAny    = false;
+  trendAccStable = true;
+
+  // mimo rozsah -> hned roztáhnout; zúžení kontrolovat jednou za oběh
+  if (c.valid && (c.lo < trendLo || c.hi > trendHi)) {
+    trendRescale();
+  } else if (++trendSinceRescale >= TREND_W) {
+    int32_t oldLo = trendLo, oldHi = trendHi;
+    bool    oldRedraw = trendFullRedraw;
+    trendRescale();
+    if (trendHi - trendLo > (oldHi - oldLo) / 2) {
+      // zúžení by nestálo za překreslení
+      trendLo = oldLo;
+      trendHi = oldHi;
+      trendFullRedraw = oldRedraw;
+    }
+  }
+}
+
+// volá se pro každý nový vzorek z HX711
+void trendSample(int32_t mg, bool stable, unsigned long nowMs) {
+  if (trendColStartMs == 0) trendColStartMs = nowMs;
+
+  // uzavřít uplynulé sloupce (bez vzorků = prázdné)
+  int guard = 0;
+  while (nowMs - trendColStartMs >= TREND_COLUMN_MS && guard++ < TREND_W) {
+    trendCommitColumn();
+    trendColStartMs += TREND_COLUMN_MS;
+  }
+  if (nowMs - trendColStartMs >= TREND_COLUMN_MS) trendColStartMs = nowMs;
+
+  if (!trendAccAny) {
+    trendAccLo  = mg;
+    trendAccHi  = mg;
+    trendAccAny = true;
+  } else {
+    if (mg < trendAccLo) trendAccLo = mg;
+    if (mg > trendAccHi) trendAccHi = mg;
+  }
+  trendAccStable = trendAccStable && stable;
+}
+
+// ========================
+// Kontrolní vážení (checkweigher)
+// ========================
+// Režim pro balicí stůl: každý kus se zváží, jakmile se na plošině ustálí,
+// a hned dostane verdikt proti cíli ± toleranci (logika viz
+// include/checkweigh.h). Kvůli propustnosti běží HX711 na 80 SPS, bere se
+// surový součet bez klouzavého průměru a HUD místo váhy ukazuje přes celou
+// plochu barvu verdiktu – kreslí se jednou na kus, ne každý snímek.
+// Konfigurace v NVS (namespace "check").
+
+// HX711 na 80 SPS, když to chce dynamické nebo kontrolní vážení
+void applyHx711Rate() {
+  if (HX711_RATE >= 0) {
+    digitalWrite(HX711_RATE, (dynamicMode || checkMode) ? HIGH : LOW);
+  }
+}
+
+void loadCheckConfig() {
+  CheckWeighParams p;
+  prefs.begin("check", true);
+  checkMode       = prefs.getBool("on", false);
+  p.targetMg      = prefs.getInt("target", p.targetMg);
+  p.underMg       = prefs.getInt("under", p.underMg);
+  p.overMg        = prefs.getInt("over", p.overMg);
+  p.loadMg        = prefs.getInt("load", p.loadMg);
+  p.settleBandMg  = prefs.getInt("band", p.settleBandMg);
+  p.settleSamples = prefs.getInt("settle", p.settleSamples);
+  p.windowUs      = prefs.getUInt("window", p.windowUs);
+  prefs.end();
+
+  checkWeigher.setParams(p);
+  checkWeigher.reset();
+  applyHx711Rate();
+}
+
+void saveCheckConfig() {
+  const CheckWeighParams& p = checkWeigher.getParams();
+  prefs.begin("check", false);
+  prefs.putBool("on", checkMode);
+  prefs.putInt("target", p.targetMg);
+  prefs.putInt("under", p.underMg);
+  prefs.putInt("over", p.overMg);
+  prefs.putInt("load", p.loadMg);
+  prefs.putInt("band", p.settleBandMg);
+  prefs.putInt("settle", p.settleSamples);
+  prefs.putUInt("window", p.windowUs);
+  prefs.end();
+}
+
+const char* checkStateName() {
+  switch (checkWeigher.getState()) {
+    case CW_SETTLING: return "settling";
+    case CW_DONE:     return "done";
+    default:          return "empty";
+  }
+}
+
+const char* checkVerdictName(CheckVerdict v) {
+  switch (v) {
+    case CV_PASS:      return "pass";
+    case CV_UNDER:     return "under";
+    case CV_OVER:      return "over";
+    case CV_UNSETTLED: return "unsettled";
+    default:           return "none";
+  }
+}
+
+// volá se pro každý nový vzorek z HX711
+void checkSample() {
+  if (!checkMode) return;
+  int st = (int)checkWeigher.getState();
+  if (checkWeigher.addSample(weighing.rawTotalMg, cellRawTimeUs)) {
+    Serial.printf("[CHECK] %s g %s\n", weightText(checkWeigher.getLastMg()).c_str(),
+                  checkVerdictName(checkWeigher.getVerdict()));
+  }
+  if ((int)checkWeigher.getState() != st) stateVersion++;
+}
+
+// ========================
+// Počítání kusů
+// ========================
+// Spouští se z menu velikostí vzorku. Nula i reference se průměrují přes
+// desítky surových vzorků (include/piece_count.h), jednotka se drží
+// v mikrogramech a s každým spolehlivě napočítaným přidáním se zpřesní.
+// Živý počet se bere z vyfiltrovaného gross, ať na displeji neposkakuje.
+
+void startCounting(int pieces) {
+  if (checkMode) {
+    // displej patří jen jednomu režimu
+    checkMode = false;
+    saveCheckConfig();
+    applyHx711Rate();
+  }
+  pieceCounter.start(pieces);
+  countMode = true;
+  stateVersion++;
+  Serial.printf("[COUNT] start, vzorek %d ks\n", pieces);
+}
+
+void stopCounting() {
+  if (!countMode) return;
+  countMode = false;
+  stateVersion++;
+  Serial.println("[COUNT] konec");
+}
+
+int currentPieceCount() {
+  if (!countMode || pieceCounter.getState() != PC_COUNTING) return 0;
+  return pieceCounter.countFor(weighing.grossMg);
+}
+
+const char* countStateName() {
+  switch (pieceCounter.getState()) {
+    case PC_ZERO:      return "zero";
+    case PC_REFERENCE: return "reference";
+    default:           return "counting";
+  }
+}
+
+// volá se pro každý nový vzorek z HX711
+void countSample() {
+  if (!countMode) return;
+  if (pieceCounter.addSample(weighing.rawTotalMg, weighing.stable)) {
+    char unit[16];
+    wpFormatMg((int32_t)pieceCounter.getUnitUg(), 3, unit);
+    Serial.printf("[COUNT] %s, ref %d ks, jednotka %s mg, max %d ks\n", countStateName(),
+                  pieceCounter.getRefPieces(), unit, pieceCounter.maxReliable());
+    stateVersion++;
+  }
+}
+
+// ========================
+// Recept
+// ========================
+// Ingredience s cílovými gramy (include/recipe.h). Váží se do jedné mísy
+// bez tárování: krok začíná tam, kde skončil předchozí, a po ustálení
+// v toleranci se sám posune dál. Text receptu se drží v LittleFS, aby
+// přežil restart; spouští se vždy znovu přes /api/recipe/start.
+const char* RECIPE_FILE_PATH = "/recipe.txt";
+
+void loadRecipe() {
+  File f = LittleFS.open(RECIPE_FILE_PATH, "r");
+  if (!f) return;
+  String text = f.readString();
+  f.close();
+  int errLine;
+  if (!recipe.parse(text.c_str(), errLine)) {
+    Serial.printf("[RECEPT] %s: chyba na radku %d\n", RECIPE_FILE_PATH, errLine);
+  }
+}
+
+void startRecipe() {
+  if (checkMode) {
+    checkMode = false;
+    saveCheckConfig();
+    applyHx711Rate();
+  }
+  recipe.start(weighing.grossMg, millis());
+  recipeMode = true;
+  lastDrawnRecipeStep = -1;
+  stateVersion++;
+  Serial.printf("[RECEPT] start, %d kroku\n", recipe.stepCount());
+}
+
+void stopRecipe() {
+  if (!recipeMode) return;
+  recipe.stop();
+  recipeMode = false;
+  stateVersion++;
+  Serial.println("[RECEPT] konec");
+}
+
+void logRecipeStep(int i) {
+  const RecipeStep& st = recipe.step(i);
+  Serial.printf("[RECEPT] %d/%d %s: %s g (cil %s g)%s\n", i + 1, recipe.stepCount(), st.name,
+                weightText(st.actualMg).c_str(), weightText(st.targetMg).c_str(), st.manual ? " rucne" : "");
+}
+
+// volá se pro každý nový vzorek z HX711
+void recipeSample() {
+  if (!recipeMode) return;
+  if (recipe.addSample(weighing.grossMg, weighing.stable, millis(), clockEpoch())) {
+    logRecipeStep(recipe.currentStep() - 1);
+    stateVersion++;
+  }
+}
+
+// ========================
+// Nový vzorek z HX711
+// ========================
+
+// vrací true, když přišel nový vzorek
+bool updateWeightFromScale() {
+  if (!loadCellsReady()) {
+    return false;
+  }
+  WdStage st(WD_LOOP, ST_SCALE);
+  cellRawTimeUs = esp_timer_get_time();
+  readLoadCellsParallel(cellRaw);
+
+  weighing.process(cellRaw, cellRawTimeUs);
+  currentWeightMg = weighing.totalMg;
+
+
+  traceSample();
+
+  if (dynamicMode && dynWeigher.addSample(currentWeightMg / 1000.0f)) {
+    Serial.printf("[DYN] HOLD %.1f g\n", dynWeigher.getHeld());
+  }
+
+  // JSON má váhu zaokrouhlenou – změna pod rozlišením novou verzi nedělá
+  int32_t shownMg  = wpRoundMg(currentWeightMg, WEIGHT_DECIMALS);
+  int     dynState = dynamicMode ? (int)dynWeigher.getState() : -1;
+  if (shownMg != versionWeightMg || weighing.stable != versionStable ||
+      dynState != versionDynState) {
+    versionWeightMg = shownMg;
+    versionStable   = weighing.stable;
+    versionDynState = dynState;
+    stateVersion++;
+  }
+
+  checkSample();
+  countSample();
+  recipeSample();
+  int count = currentPieceCount();
+  if (count != versionCount) {
+    versionCount = count;
+    stateVersion++;
+  }
+
+  streamSample();
+  trendSample(currentWeightMg, weighing.stable, millis());
+  return true;
+}
+
+// zapnutí/vypnutí dynamického vážení – při zapnutí HX711 na 80 SPS
+void setDynamicMode(bool on) {
+  if (on == dynamicMode) return;
+  dynamicMode = on;
+  dynWeigher.reset();
+  applyHx711Rate();
+  lastDrawnWeightMg = WEIGHT_NONE;
+  lastDrawnDynState = -1;
+  stateVersion++;
+  Serial.println(on ? "[DYN] zapnuto" : "[DYN] vypnuto");
+}
+
+// hodnota pro zobrazení (mg) – v dynamickém režimu robustní odhad / zamčená hodnota
+int32_t displayWeightMg() {
+  if (!dynamicMode) return currentWeightMg;
+  switch (dynWeigher.getState()) {
+    case DW_HELD:      return wpGramsToMg(dynWeigher.getHeld());
+    case DW_MEASURING: return wpGramsToMg(dynWeigher.getEstimate());
+    default:           return currentWeightMg;
+  }
+}
+
+const char* dynamicStateName() {
+  switch (dynWeigher.getState()) {
+    case DW_HELD:      return "held";
+    case DW_MEASURING: return "measuring";
+    default:           return "empty";
+  }
+}
+
+// ========================
+// WiFi – rychlé připojení a obnova spojení
+// ========================
+// Po úspěšném připojení se do NVS (namespace "wifi") uloží SSID, heslo,
+// BSSID a kanál AP. Při startu se pak jde rovnou na známý AP bez skenu
+// všech kanálů (~0.3 s místo několika sekund); když to nevyjde, přijde
+// na řadu WiFiManager jako dřív (sken, případně konfigurační portál).
+// Volitelně pevná IP (/api/wifi static=1) – odpadne i čekání na DHCP.
+//
+// Výpadky za běhu řeší task na jádře 0 (automatický reconnect ESP je
+// vypnutý): první pokusy na známý BSSID/kanál, pak obecný begin() se
+// skenem (AP mohl změnit kanál), mezi pokusy rostoucí pauza do 30 s.
+// Loop ani UI na WiFi nikdy nečekají.
+enum WifiRecState : uint8_t {
+  WR_UP = 0,            // připojeno
+  WR_WAIT,              // čeká na další pokus (backoff)
+  WR_CONNECTING         // begin() běží
+};
+
+const char* WR_STATE_NAMES[] = { "up", "wait", "connecting" };
+
+const uint32_t WIFI_FAST_TIMEOUT_MS = 2000;    // pokus na známý BSSID/kanál
+const uint32_t WIFI_SCAN_TIMEOUT_MS = 10000;   // pokus se skenem
+const int      WIFI_FAST_TRIES      = 2;       // kolik prvních pokusů je "rychlých"
+const uint32_t WIFI_BACKOFF_MIN_MS  = 250;
+const uint32_t WIFI_BACKOFF_MAX_MS  = 30000;
+
+struct WifiCache {
+  bool      valid;
+  String    ssid;
+  String    psk;
+  uint8_t   bssid[6];
+  uint8_t   channel;
+  bool      useStatic;
+  IPAddress ip, gw, mask, dns;
+};
+
+// čte i píše ji wifi task i HTTP handlery v loopu – vždy jen přes kopii
+// pod wifiLock (String uvnitř nesmí měnit dva tasky naráz)
+WifiCache         wifiCache = {};
+SemaphoreHandle_t wifiLock  = nullptr;
+
+WifiCache wifiCacheGet() {
+  xSemaphoreTake(wifiLock, portMAX_DELAY);
+  WifiCache c = wifiCache;
+  xSemaphoreGive(wifiLock);
+  return c;
+}
+
+void wifiCacheSet(const WifiCache& c) {
+  xSemaphoreTake(wifiLock, portMAX_DELAY);
+  wifiCache = c;
+  xSemaphoreGive(wifiLock);
+}
+
+// diagnostika
+volatile WifiRecState wifiState = WR_UP;
+volatile uint8_t  wifiLastReason    = 0;   // důvod posledního odpojení (wifi_err_reason_t)
+uint32_t wifiBootConnectMs  = 0;
+bool     wifiBootFast       = false;       // start prošel rychlou cestou
+uint32_t wifiDisconnects    = 0;
+uint32_t wifiReconnects     = 0;
+uint32_t wifiAttempts       = 0;           // všechny pokusy za běhu
+uint32_t wifiFastOk         = 0;           // z toho úspěšné rychlé
+uint32_t wifiLastOutageMs   = 0;
+uint32_t wifiMaxOutageMs    = 0;
+uint32_t wifiDownSinceMs    = 0;
+
+// identita ze spodku MAC – i hostname pro DHCP, proto ještě před WiFi
+void setupDeviceId() {
+  uint64_t mac = ESP.getEfuseMac();
+  snprintf(deviceId, sizeof(deviceId), "vaha-%02x%02x%02x",
+           (uint8_t)(mac >> 24), (uint8_t)(mac >> 32), (uint8_t)(mac >> 40));
+}
+
+void loadWifiCache() {
+  if (!wifiLock) wifiLock = xSemaphoreCreateMutex();
+  WifiCache& c = wifiCache;     // ještě před startem wifi tasku
+  prefs.begin("wifi", true);
+  c.ssid      = prefs.getString("ssid", "");
+  c.psk       = prefs.getString("psk", "");
+  c.valid     = prefs.getBytes("bssid", c.bssid, 6) == 6 && c.ssid.length() > 0;
+  c.channel   = prefs.getUChar("ch", 0);
+  c.useStatic = prefs.getBool("static", false);
+  c.ip   = IPAddress(prefs.getUInt("ip", 0));
+  c.gw   = IPAddress(prefs.getUInt("gw", 0));
+  c.mask = IPAddress(prefs.getUInt("mask", 0));
+  c.dns  = IPAddress(prefs.getUInt("dns", 0));
+  prefs.end();
+  if (c.channel < 1 || c.channel > 14) c.valid = false;
+}
+
+// volá se i z wifi tasku – vlastní Preferences, globální prefs patří loopu
+void saveWifiCache(const WifiCache& c) {
+  Preferences p;
+  p.begin("wifi", false);
+  p.putString("ssid", c.ssid);
+  p.putString("psk", c.psk);
+  p.putBytes("bssid", c.bssid, 6);
+  p.putUChar("ch", c.channel);
+  p.putBool("static", c.useStatic);
+  p.putUInt("ip", (uint32_t)c.ip);
+  p.putUInt("gw", (uint32_t)c.gw);
+  p.putUInt("mask", (uint32_t)c.mask);
+  p.putUInt("dns", (uint32_t)c.dns);
+  p.end();
+}
+
+// po připojení: AP, kanál a heslo do cache; do flash jen při změně
+void wifiRemember() {
+  const uint8_t* bssid = WiFi.BSSID();
+  if (!bssid) return;
+
+  // celé porovnání a úprava pod zámkem, ať se nepřepíše souběžný POST /api/wifi
+  xSemaphoreTake(wifiLock, portMAX_DELAY);
+  WifiCache& c = wifiCache;
+  bool changed = !c.valid || c.ssid != WiFi.SSID() || c.psk != WiFi.psk() ||
+                 memcmp(c.bssid, bssid, 6) != 0 || c.channel != WiFi.channel();
+  if (!c.useStatic) {
+    // poslední DHCP lease – výchozí hodnoty pro případné static=1
+    changed |= c.ip != WiFi.localIP() || c.gw != WiFi.gatewayIP() ||
+               c.mask != WiFi.subnetMask() || c.dns != WiFi.dnsIP();
+    c.ip   = WiFi.localIP();
+    c.gw   = WiFi.gatewayIP();
+    c.mask = WiFi.subnetMask();
+    c.dns  = WiFi.dnsIP();
+  }
+  if (!changed) {
+    xSemaphoreGive(wifiLock);
+    return;
+  }
+
+  c.ssid    = WiFi.SSID();
+  c.psk     = WiFi.psk();
+  memcpy(c.bssid, bssid, 6);
+  c.channel = (uint8_t)WiFi.channel();
+  c.valid   = true;
+  WifiCache copy = c;
+  xSemaphoreGive(wifiLock);
+  saveWifiCache(copy);
+  Serial.printf("[WIFI] cache: %s ch %d\n", WiFi.BSSIDstr().c_str(), copy.channel);
+}
+
+// begin() na známý AP (fast) nebo obecně se skenem
+// bez SSID v cache (ještě nic neuložila) begin() bez argumentů – vezme
+// údaje, které si uložil WiFiManager
+void wifiBegin(bool fast) {
+  WifiCache c = wifiCacheGet();
+  if (c.useStatic && (uint32_t)c.ip != 0) WiFi.config(c.ip, c.gw, c.mask, c.dns);
+  else                                    WiFi.config(IPAddress(), IPAddress(), IPAddress());
+  if (c.ssid.length() == 0)  WiFi.begin();
+  else if (fast && c.valid)  WiFi.begin(c.ssid.c_str(), c.psk.c_str(), c.channel, c.bssid, true);
+  else                       WiFi.begin(c.ssid.c_str(), c.psk.c_str());
+}
+
+// start: rychlá cesta, false = nevyšlo (pak WiFiManager)
+bool wifiFastConnect() {
+  if (!wifiCacheGet().valid) return false;
+  unsigned long startMs = millis();
+  wifiBegin(true);
+  while (WiFi.status() != WL_CONNECTED) {
+    if (millis() - startMs > WIFI_FAST_TIMEOUT_MS) {
+      WiFi.disconnect();
+      Serial.println("[WIFI] rychle pripojeni selhalo -> WiFiManager");
+      return false;
+    }
+    delay(10);
+  }
+  wifiBootConnectMs = millis() - startMs;
+  wifiBootFast      = true;
+  Serial.printf("[WIFI] rychle pripojeni za %u ms\n", (unsigned)wifiBootConnectMs);
+  return true;
+}
+
+void onWifiEvent(arduino_event_id_t event, arduino_event_info_t info) {
+  if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+    wifiLastReason = info.wifi_sta_disconnected.reason;
+  }
+}
+
+void wifiTask(void*) {
+  int wd = wdRegister("wifi", 3000);
+  uint32_t tryStartMs = 0, nextTryMs = 0, backoffMs = WIFI_BACKOFF_MIN_MS;
+  int  attempt = 0;
+  bool fast    = false;
+
+  for (;;) {
+    wdBeat(wd);
+    vTaskDelay(pdMS_TO_TICKS(100));
+    uint32_t now = millis();
+    bool up = WiFi.status() == WL_CONNECTED;
+
+    if (up) {
+      if (wifiState != WR_UP) {
+        wifiLastOutageMs = now - wifiDownSinceMs;
+        if (wifiLastOutageMs > wifiMaxOutageMs) wifiMaxOutageMs = wifiLastOutageMs;
+        wifiReconnects++;
+        if (fast) wifiFastOk++;
+        wifiState = WR_UP;
+        Serial.printf("[WIFI] znovu pripojeno za %u ms (%d. pokus)\n",
+                      (unsigned)wifiLastOutageMs, attempt);
+        wifiRemember();   // mohl se změnit AP (roaming)
+      }
+      continue;
+    }
+
+    switch (wifiState) {
+      case WR_UP:
+        wifiDisconnects++;
+        wifiDownSinceMs = now;
+        attempt   = 0;
+        backoffMs = WIFI_BACKOFF_MIN_MS;
+        nextTryMs = now;        // první pokus hned
+        wifiState = WR_WAIT;
+        Serial.printf("[WIFI] odpojeno (reason %u)\n", (unsigned)wifiLastReason);
+        break;
+
+      case WR_WAIT:
+        if ((int32_t)(now - nextTryMs) < 0) break;
+        attempt++;
+        wifiAttempts++;
+        fast = wifiCacheGet().valid && attempt <= WIFI_FAST_TRIES;
+        wifiBegin(fast);
+        tryStartMs = now;
+        wifiState  = WR_CONNECTING;
+        break;
+
+      case WR_CONNECTING:
+      default:
+        if (now - tryStartMs < (fast ? WIFI_FAST_TIMEOUT_MS : WIFI_SCAN_TIMEOUT_MS)) break;
+        WiFi.disconnect();
+        nextTryMs = now + backoffMs;
+        backoffMs = backoffMs * 2 > WIFI_BACKOFF_MAX_MS ? WIFI_BACKOFF_MAX_MS : backoffMs * 2;
+        wifiState = WR_WAIT;
+        break;
+    }
+  }
+}
+
+// po připojení v setup(): cache, vlastní reconnect místo vestavěného
+void setupWifiRecovery() {
+  wifiRemember();
+  WiFi.setAutoReconnect(false);
+  WiFi.onEvent(onWifiEvent);
+  xTaskCreatePinnedToCore(wifiTask, "wifi", 4096, nullptr, 1, nullptr, 0);
+}
+
+// ========================
+// MQTT
+// ========================
+// Publikování běží ve vlastním tasku na jádře 0 – připojení k brokeru ani
+// pomalá síť tak nikdy nezdrží loop(). Loop jen vkládá vzorky a události
+// do front (bez čekání). Když broker není dostupný, vzorky se hromadí
+// v omezené frontě (nejstarší se zahazují) a po připojení se odešlou
+// po dávkách do <base>/history.
+struct MqttConfig {
+  bool     enabled;
+  char     host[64];
+  uint16_t port;
+  char     user[32];
+  char     pass[32];
+  char     base[48];          // kořen topiců, výchozí smartscale/<deviceId>
+  uint32_t intervalMs;        // max frekvence publikování stavu
+};
+
+struct MqttSample {
+  uint32_t epoch;             // 0 = čas ještě není
+  uint32_t uptimeMs;
+  int32_t  weightMg;
+  bool     stable;
+};
+
+struct MqttEvent {
+  char type[12];
+  char value[32];
+};
+
+const int MQTT_SAMPLE_QUEUE = 512;    // ~2 min historie při 250 ms
+const int MQTT_EVENT_QUEUE  = 16;
+const int MQTT_BATCH        = 32;     // vzorků v jedné history zprávě
+// nejdelší položka history: {"ts":4294967295,"up":4294967295,"w":-8388608.0,"s":1},
+const int MQTT_ENTRY_MAX    = 64;
+// buffer PubSubClient = celá zpráva včetně topicu a hlavičky
+const int MQTT_BUFFER       = MQTT_BATCH * MQTT_ENTRY_MAX + 256;
+
+MqttConfig mqttCfg;
+volatile uint32_t mqttCfgVersion = 0;
+static portMUX_TYPE mqttMux = portMUX_INITIALIZER_UNLOCKED;
+
+QueueHandle_t mqttSamples = nullptr;
+QueueHandle_t mqttEvents  = nullptr;
+char mqttItem[32] = "Nic";             // kopie currentItem pro task (pod mqttMux)
+
+volatile bool     mqttConnected = false;
+volatile uint32_t mqttPublished = 0;
+volatile uint32_t mqttDropped   = 0;
+volatile uint32_t mqttReconnects = 0;
+
+// stav na straně loopu (koalescence)
+unsigned long mqttLastSampleMs = 0;
+int32_t       mqttLastWeightMg = WEIGHT_NONE;
+bool          mqttLastStable   = false;
+
+void loadMqttConfig() {
+  MqttConfig c;
+  prefs.begin("mqtt", true);
+  c.enabled = prefs.getBool("on", false);
+  strlcpy(c.host, prefs.getString("host", "").c_str(), sizeof(c.host));
+  c.port = prefs.getUShort("port", 1883);
+  strlcpy(c.user, prefs.getString("user", "").c_str(), sizeof(c.user));
+  strlcpy(c.pass, prefs.getString("pass", "").c_str(), sizeof(c.pass));
+  String base = prefs.getString("base", "");
+  c.intervalMs = prefs.getUInt("ivl", 1000);
+  prefs.end();
+
+  if (base.length() == 0) base = String("smartscale/") + deviceId;
+  strlcpy(c.base, base.c_str(), sizeof(c.base));
+
+  portENTER_CRITICAL(&mqttMux);
+  mqttCfg = c;
+  mqttCfgVersion++;
+  portEXIT_CRITICAL(&mqttMux);
+}
+
+void saveMqttConfig(const MqttConfig& c) {
+  prefs.begin("mqtt", false);
+  prefs.putBool("on", c.enabled);
+  prefs.putString("host", c.host);
+  prefs.putUShort("port", c.port);
+  prefs.putString("user", c.user);
+  prefs.putString("pass", c.pass);
+  prefs.putString("base", c.base);
+  prefs.putUInt("ivl", c.intervalMs);
+  prefs.end();
+}
+
+// z loopu – nikdy neblokuje; plná fronta zahodí nejstarší záznam
+template <typename T>
+void mqttQueuePush(QueueHandle_t q, const T& item) {
+  if (!q) return;
+  if (xQueueSend(q, &item, 0) != pdTRUE) {
+    T old;
+    xQueueReceive(q, &old, 0);
+    mqttDropped++;
+    xQueueSend(q, &item, 0);
+  }
+}
+
+void mqttEvent(const char* type, const char* value) {
+  MqttEvent e;
+  strlcpy(e.type, type, sizeof(e.type));
+  strlcpy(e.value, value ? value : "", sizeof(e.value));
+  mqttQueuePush(mqttEvents, e);
+}
+
+void mqttSetItem(const String& item) {
+  portENTER_CRITICAL(&mqttMux);
+  strlcpy(mqttItem, item.c_str(), sizeof(mqttItem));
+  portEXIT_CRITICAL(&mqttMux);
+  mqttEvent("item", item.c_str());
+}
+
+// volá se z loopu; vzorek jen když uplynul interval a něco se změnilo
+// (nebo po 30 s jako heartbeat)
+void mqttNoteState() {
+  if (!mqttCfg.enabled) return;
+
+  unsigned long now = millis();
+  if (now - mqttLastSampleMs < mqttCfg.intervalMs) return;
+
+  int32_t shownMg = wpRoundMg(currentWeightMg, WEIGHT_DECIMALS);
+  bool changed = shownMg != mqttLastWeightMg || weighing.stable != mqttLastStable;
+  if (!changed && now - mqttLastSampleMs < 30000) return;
+
+  MqttSample smp;
+  smp.epoch    = clockEpoch();
+  smp.uptimeMs = now;
+  smp.weightMg = currentWeightMg;
+  smp.stable   = weighing.stable;
+  mqttQueuePush(mqttSamples, smp);
+
+  mqttLastSampleMs = now;
+  mqttLastWeightMg = shownMg;
+  mqttLastStable   = weighing.stable;
+}
+
+// ---- strana tasku ----
+
+WiFiClient   mqttNet;
+PubSubClient mqtt(mqttNet);
+
+void mqttPublishDiscovery(const MqttConfig& c) {
+  char topic[96];
+  char payload[640];
+  char dev[160];
+  snprintf(dev, sizeof(dev),
+           "\"device\":{\"identifiers\":[\"%s\"],\"name\":\"Chytra vaha %s\","
+           "\"manufacturer\":\"krumpex\",\"model\":\"smart_scale\"}",
+           deviceId, deviceId);
+
+  snprintf(topic, sizeof(topic), "homeassistant/sensor/%s/weight/config", deviceId);
+  snprintf(payload, sizeof(payload),
+           "{\"name\":\"Hmotnost\",\"unique_id\":\"%s_weight\",\"state_topic\":\"%s/state\","
+           "\"value_template\":\"{{ value_json.weight }}\",\"unit_of_measurement\":\"g\","
+           "\"device_class\":\"weight\",\"state_class\":\"measurement\","
+           "\"availability_topic\":\"%s/status\",%s}",
+           deviceId, c.base, c.base, dev);
+  mqtt.publish(topic, payload, true);
+
+  snprintf(topic, sizeof(topic), "homeassistant/binary_sensor/%s/stable/config", deviceId);
+  snprintf(payload, sizeof(payload),
+           "{\"name\":\"Ustaleno\",\"unique_id\":\"%s_stable\",\"state_topic\":\"%s/state\","
+           "\"value_template\":\"{{ 'ON' if value_json.stable else 'OFF' }}\","
+           "\"availability_topic\":\"%s/status\",%s}",
+           deviceId, c.base, c.base, dev);
+  mqtt.publish(topic, payload, true);
+
+  snprintf(topic, sizeof(topic), "homeassistant/sensor/%s/item/config", deviceId);
+  snprintf(payload, sizeof(payload),
+           "{\"name\":\"Polozka\",\"unique_id\":\"%s_item\",\"state_topic\":\"%s/state\","
+           "\"value_template\":\"{{ value_json.item }}\","
+           "\"availability_topic\":\"%s/status\",%s}",
+           deviceId, c.base, c.base, dev);
+  mqtt.publish(topic, payload, true);
+}
+
+bool mqttPublishState(const MqttConfig& c, const MqttSample& smp) {
+  char raw[32];
+  portENTER_CRITICAL(&mqttMux);
+  strlcpy(raw, mqttItem, sizeof(raw));
+  portEXIT_CRITICAL(&mqttMux);
+  char item[96];
+  jsonEscape(item, sizeof(item), raw);
+
+  char topic[64];
+  char payload[224];
+  char weight[16];
+  wpFormatMg(smp.weightMg, WEIGHT_DECIMALS, weight);
+  snprintf(topic, sizeof(topic), "%s/state", c.base);
+  snprintf(payload, sizeof(payload), "{\"weight\":%s,\"stable\":%s,\"item\":\"%s\",\"ts\":%u}",
+           weight, smp.stable ? "true" : "false", item, (unsigned)smp.epoch);
+  return mqtt.publish(topic, payload, true);
+}
+
+// vyprázdní frontu vzorků: víc než jeden = historie z doby bez spojení
+// rozpracovaná history dávka – z fronty už vyzvednutá, ale ještě neodeslaná;
+// při neúspěšném publish zůstane a po reconnectu jde znovu (jen mqtt task)
+MqttSample mqttPending[MQTT_BATCH];
+volatile int mqttPendingCount = 0;
+
+bool mqttDrainSamples(const MqttConfig& c) {
+  MqttSample* batch = mqttPending;
+  while (mqttPendingCount > 0 || uxQueueMessagesWaiting(mqttSamples) > 1) {
+    int n = mqttPendingCount;
+    while (n < MQTT_BATCH && uxQueueMessagesWaiting(mqttSamples) > 1 &&
+           xQueueReceive(mqttSamples, &batch[n], 0) == pdTRUE) {
+      n++;
+    }
+    mqttPendingCount = n;
+
+    String json;
+    json.reserve(n * MQTT_ENTRY_MAX + 2);
+    json += "[";
+    for (int i = 0; i < n; i++) {
+      if (i > 0) json += ",";
+      json += "{\"ts\":" + String(batch[i].epoch) + ",\"up\":" + String(batch[i].uptimeMs);
+      json += ",\"w\":" + weightText(batch[i].weightMg) + ",\"s\":" + String(batch[i].stable ? 1 : 0) + "}";
+    }
+    json += "]";
+
+    char topic[64];
+    snprintf(topic, sizeof(topic), "%s/history", c.base);
+    if (!mqtt.publish(topic, json.c_str())) return false;
+    mqttPendingCount = 0;
+    mqttPublished++;
+    mqtt.loop();
+  }
+
+  MqttSample last;
+  if (xQueueReceive(mqttSamples, &last, 0) == pdTRUE) {
+    if (!mqttPublishState(c, last)) return false;
+    mqttPublished++;
+  }
+  return true;
+}
+
+// událost se z fronty vyndá až po úspěšném publish (peek -> receive)
+bool mqttDrainEvents(const MqttConfig& c) {
+  MqttEvent e;
+  while (xQueuePeek(mqttEvents, &e, 0) == pdTRUE) {
+    char topic[64];
+    char value[sizeof(e.value) * 6];   // jméno položky / nádoby, escapované
+    char payload[64 + sizeof(value)];
+    jsonEscape(value, sizeof(value), e.value);
+    snprintf(topic, sizeof(topic), "%s/event", c.base);
+    snprintf(payload, sizeof(payload), "{\"type\":\"%s\",\"value\":\"%s\",\"up\":%lu}",
+             e.type, value, millis());
+    if (!mqtt.publish(topic, payload)) return false;
+    xQueueReceive(mqttEvents, &e, 0);
+    mqttPublished++;
+  }
+  return true;
+}
+
+void mqttTask(void*) {
+  MqttConfig c;
+  uint32_t cfgVersion = 0;
+  unsigned long backoffMs = 1000;
+  unsigned long lastAttemptMs = 0;
+  char statusTopic[64];
+
+  int wd = wdRegister("mqtt", 15000);   // connect smí trvat (DNS + socket timeout)
+
+  if (!mqtt.setBufferSize(MQTT_BUFFER)) Serial.println("[MQTT] buffer se nealokoval");
+  mqtt.setSocketTimeout(3);
+  mqtt.setKeepAlive(30);
+
+  for (;;) {
+    wdBeat(wd);
+
+    // nová konfigurace -> odpojit a začít znovu
+    if (cfgVersion != mqttCfgVersion) {
+      portENTER_CRITICAL(&mqttMux);
+      c = mqttCfg;
+      cfgVersion = mqttCfgVersion;
+      portEXIT_CRITICAL(&mqttMux);
+      if (mqtt.connected()) mqtt.disconnect();
+      mqtt.setServer(c.host, c.port);
+      backoffMs = 1000;
+      lastAttemptMs = 0;
+      snprintf(statusTopic, sizeof(statusTopic), "%s/status", c.base);
+    }
+
+    if (!c.enabled || c.host[0] == 0 || WiFi.status() != WL_CONNECTED) {
+      mqttConnected = false;
+      vTaskDelay(pdMS_TO_TICKS(500));
+      continue;
+    }
+
+    if (!mqtt.connected()) {
+      mqttConnected = false;
+      if (lastAttemptMs && millis() - lastAttemptMs < backoffMs) {
+        vTaskDelay(pdMS_TO_TICKS(100));
+        continue;
+      }
+      lastAttemptMs = millis();
+
+      WdStage st(wd, ST_MQTT_CONNECT);
+      bool ok = mqtt.connect(deviceId,
+                             c.user[0] ? c.user : nullptr, c.pass[0] ? c.pass : nullptr,
+                             statusTopic, 0, true, "offline");
+      if (!ok) {
+        Serial.printf("[MQTT] connect %s:%u selhal (%d), dalsi za %lu ms\n",
+                      c.host, c.port, mqtt.state(), backoffMs);
+        backoffMs = backoffMs * 2 > 60000 ? 60000 : backoffMs * 2;
+        continue;
+      }
+
+      mqttReconnects++;
+      backoffMs = 1000;
+      mqtt.publish(statusTopic, "online", true);
+      mqttPublishDiscovery(c);
+      mqttConnected = true;
+      Serial.printf("[MQTT] pripojeno k %s:%u\n", c.host, c.port);
+    }
+
+    WdStage st(wd, ST_MQTT_PUBLISH);
+    mqtt.loop();
+    if (!mqttDrainEvents(c) || !mqttDrainSamples(c)) {
+      // publish selhal – odpojit a znovu přes reconnect; rozeslaná dávka
+      // se ztratí, zbytek fronty počká na spojení
+      mqtt.disconnect();
+    }
+    vTaskDelay(pdMS_TO_TICKS(50));
+  }
+}
+
+void setupMqtt() {
+  mqttSamples = xQueueCreate(MQTT_SAMPLE_QUEUE, sizeof(MqttSample));
+  mqttEvents  = xQueueCreate(MQTT_EVENT_QUEUE, sizeof(MqttEvent));
+  loadMqttConfig();
+
+  xTaskCreatePinnedToCore(mqttTask, "mqtt", 6144, nullptr, 1, nullptr, 0);
+}
+
+// ========================
+// Snímek obrazovky
+// ========================
+// /api/screenshot předá spojení tasku na jádře 0 a hned se vrátí – loop
+// (a tím i UI) kreslí dál. Task čte stínový buffer po řádcích, kóduje je
+// (include/screen_encode.h) a posílá jako HTTP chunked odpověď po ~4 kB.
+// Celý obrázek se nikde nekopíruje; řádek se vezme najednou, takže se
+// může "roztrhnout" jen mezi řádky, když se zrovna kreslí.
+const size_t SHOT_CHUNK = 4096;
+
+WiFiClient    shotClient;
+ScreenFormat  shotFormat = SE_BMP;
+TaskHandle_t  shotTaskHandle = nullptr;
+volatile bool shotBusy = false;
+uint32_t      shotCount   = 0;
+uint32_t      shotErrors  = 0;
+uint32_t      shotLastMs  = 0;     // jak dlouho trval poslední snímek
+
+// jeden HTTP chunk; false = klient odpadl
+bool shotWriteChunk(const uint8_t* p, size_t len) {
+  char head[12];
+  int n = snprintf(head, sizeof(head), "%X\r\n", (unsigned)len);
+  return shotClient.write((const uint8_t*)head, n) == (size_t)n &&
+         shotClient.write(p, len) == len &&
+         shotClient.write((const uint8_t*)"\r\n", 2) == 2;
+}
+
+void shotTask(void*) {
+  static uint8_t  buf[SHOT_CHUNK];
+  static uint16_t line[SE_MAX_WIDTH];
+
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    unsigned long startMs = millis();
+
+    ScreenEncoder enc;
+    enc.begin(shotFormat, tft.width(), tft.height());
+
+    String head = "HTTP/1.1 200 OK\r\nContent-Type: ";
+    head += enc.contentType();
+    head += "\r\nTransfer-Encoding: chunked\r\nCache-Control: no-store\r\nConnection: close\r\n\r\n";
+    bool ok = shotClient.write((const uint8_t*)head.c_str(), head.length()) == head.length();
+
+    size_t used = enc.header(buf);
+    while (ok && !enc.done()) {
+      if (used + SE_MAX_ROW_BYTES > SHOT_CHUNK) {
+        ok = shotWriteChunk(buf, used);
+        used = 0;
+      }
+      memcpy(line, tft.shadowRow(enc.nextRowY()), tft.width() * sizeof(uint16_t));
+      used += enc.row(line, buf + used);
+    }
+    if (ok) {
+      used += enc.trailer(buf + used);
+      ok = shotWriteChunk(buf, used) &&
+           shotClient.write((const uint8_t*)"0\r\n\r\n", 5) == 5;
+    }
+
+    shotClient.stop();
+    shotClient = WiFiClient();
+    if (ok) shotCount++;
+    else    shotErrors++;
+    shotLastMs = millis() - startMs;
+    shotBusy   = false;
+  }
+}
+
+void setupScreenshot() {
+  if (!tft.beginShadow()) {
+    Serial.println("[SHOT] bez PSRAM – snimky obrazovky nejdou");
+    return;
+  }
+  xTaskCreatePinnedToCore(shotTask, "shot", 3072, nullptr, 1, &shotTaskHandle, 0);
+}
+
+// ========================
+// Flotila – ostatní váhy v síti (mDNS)
+// ========================
+// Každá váha je <deviceId>.local a ohlašuje službu _vaha._tcp s TXT id
+// a caps (co umí). Task na jádře 0 ostatní váhy hledá a ptá se jich
+// na /api/summary; /api/fleet pak vrací jen cache. Skenuje se, jen když
+// se někdo na /api/fleet díval v posledních FLEET_IDLE_MS.
+//
+// Dotazy jdou souběžně přes neblokující sockety: všechny connecty se
+// spustí naráz a jeden select() pak hlídá dokončení connectů i odpovědi
+// se společným termínem – vypnutá váha zdrží sken nejvýš o FLEET_TIMEOUT_MS,
+// ne o FLEET_CONNECT_MS za každou. Z odpovědi se berou jen známá pole
+// (váha, ustálení, položka, režim); do /api/fleet jdou znovu escapovaná.
+const int      FLEET_MAX_PEERS   = 12;
+const uint32_t FLEET_REFRESH_MS  = 5000;     // interval skenu
+const uint32_t FLEET_IDLE_MS     = 60000;    // bez dotazů déle -> neskenovat
+const uint32_t FLEET_CONNECT_MS  = 300;      // connect na jednu váhu
+const uint32_t FLEET_TIMEOUT_MS  = 800;      // všechny odpovědi dohromady
+const uint32_t FLEET_FORGET_MS   = 60000;    // váha, která zmizela z mDNS
+const size_t   FLEET_MAX_BODY    = 512;
+const char*    FLEET_CAPS        = "check,count,recipe,dynamic,screenshot,stream,mqtt";
+
+struct FleetPeer {
+  char      id[16];
+  char      host[40];
+  IPAddress ip;
+  uint16_t  port;
+  bool      ok;            // poslední dotaz vyšel
+  uint32_t  seenMs;        // naposledy v mDNS
+  uint32_t  okMs;          // naposledy odpověděla
+  uint16_t  latencyMs;
+  // z posledního /api/summary (platí, když okMs != 0)
+  int32_t   weightMg;
+  bool      stable;
+  char      item[48];
+  char      mode[12];
+};
+
+FleetPeer         fleetPeers[FLEET_MAX_PEERS];
+int               fleetPeerCount = 0;
+SemaphoreHandle_t fleetLock      = nullptr;
+TaskHandle_t      fleetTaskHandle = nullptr;
+volatile uint32_t fleetWantedMs  = 0;        // poslední /api/fleet
+uint32_t          fleetScanMs    = 0;        // konec posledního skenu
+uint32_t          fleetScanDurMs = 0;
+uint32_t          fleetScans     = 0;
+
+// jeden dotaz na /api/summary (HTTP/1.0, Connection: close)
+enum FleetFetchState { FF_CONNECTING, FF_READING, FF_DONE, FF_FAILED };
+
+struct FleetFetch {
+  int      fd;
+  uint8_t  state;
+  String   resp;
+  uint32_t startMs;
+  uint32_t doneMs;
+};
+
+// vytáhne tělo ze stavové řádky 200; jinak prázdný string
+String fleetBody(const String& resp) {
+  if (!resp.startsWith("HTTP/1.") || resp.indexOf(" 200 ") != 8) return String();
+  int p = resp.indexOf("\r\n\r\n");
+  if (p < 0) return String();
+  String body = resp.substring(p + 4);
+  body.trim();
+  return body.startsWith("{") && body.endsWith("}") ? body : String();
+}
+
+// hodnota klíče v plochém JSON z /api/summary; index za dvojtečkou nebo -1
+int fleetJsonFind(const String& body, const char* key) {
+  String k = String("\"") + key + "\":";
+  int p = body.indexOf(k.c_str());
+  return p < 0 ? -1 : p + (int)k.length();
+}
+
+// řetězec bez escapování; \uXXXX mimo ASCII -> '?', co se nevejde, se usekne
+bool fleetJsonStr(const String& body, const char* key, char* dst, size_t len) {
+  int p = fleetJsonFind(body, key);
+  if (p < 0 || body[p] != '"') return false;
+  size_t j = 0;
+  for (p++; p < (int)body.length(); p++) {
+    char c = body[p];
+    if (c == '"') {
+      dst[j] = 0;
+      return true;
+    }
+    if (c == '\\') {
+      if (++p >= (int)body.length()) break;
+      c = body[p];
+      if (c == 'n')      c = '\n';
+      else if (c == 't') c = '\t';
+      else if (c == 'u') {
+        if (p + 4 >= (int)body.length()) break;
+        long u = strtol(body.substring(p + 1, p + 5).c_str(), nullptr, 16);
+        c = u > 0 && u < 0x80 ? (char)u : '?';
+        p += 4;
+      }
+    }
+    if (j + 1 < len) dst[j++] = c;
+  }
+  return false;
+}
+
+// /api/summary -> pole peeru; false = chybí nebo nesedí
+bool fleetParseSummary(const String& body, FleetPeer& p) {
+  int w = fleetJsonFind(body, "weight");
+  int s = fleetJsonFind(body, "stable");
+  if (w < 0 || s < 0) return false;
+  char* end = nullptr;
+  double g = strtod(body.c_str() + w, &end);
+  if (end == body.c_str() + w || g > 2e6 || g < -2e6) return false;
+
+  char item[sizeof(p.item)], mode[sizeof(p.mode)];
+  if (!fleetJsonStr(body, "item", item, sizeof(item))) return false;
+  if (!fleetJsonStr(body, "mode", mode, sizeof(mode))) return false;
+  p.weightMg = (int32_t)lround(g * 1000.0);
+  p.stable   = strncmp(body.c_str() + s, "true", 4) == 0;
+  strlcpy(p.item, item, sizeof(p.item));
+  strlcpy(p.mode, mode, sizeof(p.mode));
+  return true;
+}
+
+// neblokující connect; false = socket nejde vůbec založit
+bool fleetConnect(FleetFetch& f, IPAddress ip, uint16_t port) {
+  f.resp    = String();
+  f.startMs = millis();
+  f.state   = FF_FAILED;
+  f.fd      = socket(AF_INET, SOCK_STREAM, 0);
+  if (f.fd < 0) return false;
+  fcntl(f.fd, F_SETFL, fcntl(f.fd, F_GETFL, 0) | O_NONBLOCK);
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family      = AF_INET;
+  addr.sin_port        = htons(port);
+  addr.sin_addr.s_addr = (uint32_t)ip;
+  if (connect(f.fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS) {
+    close(f.fd);
+    f.fd = -1;
+    return false;
+  }
+  f.state = FF_CONNECTING;
+  return true;
+}
+
+void fleetScan() {
+  static FleetFetch f[FLEET_MAX_PEERS];
+  static char       ids[FLEET_MAX_PEERS][16];
+  static char       hosts[FLEET_MAX_PEERS][40];
+  IPAddress ips[FLEET_MAX_PEERS];
+  uint16_t  ports[FLEET_MAX_PEERS];
+  unsigned long startMs = millis();
+
+  // 1) kdo je v síti (blokuje až ~3 s, proto v tasku)
+  int found = MDNS.queryService("vaha", "tcp");
+  int n = 0;
+  for (int i = 0; i < found && n < FLEET_MAX_PEERS; i++) {
+    String id = MDNS.txt(i, "id");
+    if (id.length() == 0 || id == deviceId) continue;
+    strlcpy(ids[n], id.c_str(), sizeof(ids[n]));
+    snprintf(hosts[n], sizeof(hosts[n]), "%s.local", MDNS.hostname(i).c_str());
+    ips[n]   = MDNS.IP(i);
+    ports[n] = MDNS.port(i);
+    n++;
+  }
+
+  // 2) všechny connecty najednou
+  for (int k = 0; k < n; k++) fleetConnect(f[k], ips[k], ports[k]);
+
+  // 3) connecty i odpovědi v jednom select() se společným termínem
+  uint32_t deadline = millis() + FLEET_TIMEOUT_MS;
+  for (;;) {
+    fd_set rd, wr;
+    FD_ZERO(&rd);
+    FD_ZERO(&wr);
+    int maxFd = -1;
+    for (int k = 0; k < n; k++) {
+      if (f[k].state == FF_CONNECTING && millis() - f[k].startMs > FLEET_CONNECT_MS) {
+        f[k].state = FF_FAILED;
+      }
+      if (f[k].state == FF_CONNECTING)   FD_SET(f[k].fd, &wr);
+      else if (f[k].state == FF_READING) FD_SET(f[k].fd, &rd);
+      else continue;
+      if (f[k].fd > maxFd) maxFd = f[k].fd;
+    }
+    int32_t left = (int32_t)(deadline - millis());
+    if (maxFd < 0 || left <= 0) break;
+
+    // krátký krok, ať se hlídá i FLEET_CONNECT_MS jednotlivých connectů
+    struct timeval tv = { 0, (left < 50 ? left : 50) * 1000 };
+    if (select(maxFd + 1, &rd, &wr, nullptr, &tv) < 0) break;
+
+    for (int k = 0; k < n; k++) {
+      FleetFetch& q = f[k];
+      if (q.state == FF_CONNECTING && FD_ISSET(q.fd, &wr)) {
+        int err = 0;
+        socklen_t errLen = sizeof(err);
+        getsockopt(q.fd, SOL_SOCKET, SO_ERROR, &err, &errLen);
+        char req[96];
+        int reqLen = snprintf(req, sizeof(req),
+                              "GET /api/summary HTTP/1.0\r\nHost: %s\r\nConnection: close\r\n\r\n",
+                              hosts[k]);
+        // request je malý, vejde se do prázdného send bufferu najednou
+        bool sent = err == 0 && reqLen < (int)sizeof(req) && send(q.fd, req, reqLen, 0) == reqLen;
+        q.state = sent ? FF_READING : FF_FAILED;
+      } else if (q.state == FF_READING && FD_ISSET(q.fd, &rd)) {
+        char buf[256];
+        int r = recv(q.fd, buf, sizeof(buf), 0);
+        if (r > 0) {
+          if (q.resp.length() < FLEET_MAX_BODY + 256) q.resp.concat(buf, r);
+        } else if (r == 0) {
+          q.state  = FF_DONE;
+          q.doneMs = millis();
+        } else if (errno != EWOULDBLOCK && errno != EAGAIN) {
+          q.state = FF_FAILED;
+        }
+      }
+    }
+  }
+
+  // 4) výsledky do tabulky
+  uint32_t now = millis();
+  xSemaphoreTake(fleetLock, portMAX_DELAY);
+  for (int k = 0; k < n; k++) {
+    String body = f[k].state == FF_DONE ? fleetBody(f[k].resp) : String();
+    if (f[k].fd >= 0) close(f[k].fd);
+    f[k].fd = -1;
+    if (body.length() > FLEET_MAX_BODY) body = String();
+
+    FleetPeer* p = nullptr;
+    for (int i = 0; i < fleetPeerCount; i++) {
+      if (strcmp(fleetPeers[i].id, ids[k]) == 0) p = &fleetPeers[i];
+    }
+    if (!p) {
+      if (fleetPeerCount >= FLEET_MAX_PEERS) continue;
+      p = &fleetPeers[fleetPeerCount++];
+      strlcpy(p->id, ids[k], sizeof(p->id));
+      p->okMs = 0;
+    }
+    strlcpy(p->host, hosts[k], sizeof(p->host));
+    p->ip     = ips[k];
+    p->port   = ports[k];
+    p->seenMs = now;
+    p->ok     = body.length() > 0 && fleetParseSummary(body, *p);
+    if (p->ok) {
+      p->okMs      = now;
+      p->latencyMs = (uint16_t)(f[k].doneMs - f[k].startMs);
+    }
+  }
+  // neodpovídá a v mDNS už dlouho není -> pryč
+  for (int i = 0; i < fleetPeerCount; ) {
+    FleetPeer& p = fleetPeers[i];
+    if (p.seenMs != now) p.ok = false;
+    if (now - p.seenMs > FLEET_FORGET_MS) {
+      fleetPeers[i] = fleetPeers[--fleetPeerCount];
+    } else {
+      i++;
+    }
+  }
+  fleetScanMs    = now;
+  fleetScanDurMs = now - startMs;
+  fleetScans++;
+  xSemaphoreGive(fleetLock);
+}
+
+void fleetTask(void*) {
+  for (;;) {
+    // probudí ho první /api/fleet po pauze, jinak jede v intervalu
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(FLEET_REFRESH_MS));
+    if (WiFi.status() != WL_CONNECTED) continue;
+    if (!fleetWantedMs || millis() - fleetWantedMs > FLEET_IDLE_MS) continue;
+    fleetScan();
+  }
+}
+
+void setupFleet() {
+  fleetLock = xSemaphoreCreateMutex();
+  xTaskCreatePinnedToCore(fleetTask, "fleet", 6144, nullptr, 1, &fleetTaskHandle, 0);
+}
+
+// ========================
+// Nádoby (tara)
+// ========================
+// Tabulka nádob v NVS (namespace "tara"). grams <= 0 = ještě nenaučená –
+// při výběru se naučí z toho, co právě leží na prázdné váze.
+struct TareContainer {
+  char  name[24];
+  float grams;
+};
+
+const int MAX_CONTAINERS = 32;
+
+// výchozí seznam při prvním startu
+const char* DEFAULT_CONTAINERS[] = {
+  "Mala miska plastova",
+  "Maly hrnecek",
+  "Velky hrnek",
+  "melky talir 1",
+  "melky talir 2"
+};
+
+TareContainer containers[MAX_CONTAINERS];
+int containerCount  = 0;
+int activeContainer = -1;          // -1 = bez nádoby
+
+// čekající učení nádoby (index). Na váze se nejdřív musí něco změnit
+// (nádoba položena / vyměněna) – teprve pak se vezme první ustálená
+// hodnota, jinak by se "naučilo" to, co na váze leželo před výběrem.
+int learnContainer = -1;
+unsigned long learnStartMs = 0;
+int32_t learnStartGrossMg  = 0;
+bool    learnChangeSeen    = false;
+const unsigned long LEARN_TIMEOUT_MS = 8000;   // na položení, pak znovu na ustálení
+const int32_t LEARN_CHANGE_MG = 2000;          // změna, která se počítá jako položení
+const int32_t LEARN_MIN_MG    = 2000;          // lehčí nádoba = prázdná váha
+
+enum LearnResult {
+  LEARN_PENDING = 0,    // nic se neučí nebo se čeká
+  LEARN_DONE,
+  LEARN_TIMEOUT
+};
+
+void saveContainers() {
+  prefs.begin("tara", false);
+  prefs.putInt("n", containerCount);
+  prefs.putBytes("list", containers, sizeof(TareContainer) * containerCount);
+  prefs.end();
+  stateVersion++;
+}
+
+void loadContainers() {
+  prefs.begin("tara", true);
+  containerCount = prefs.getInt("n", -1);
+  if (containerCount > MAX_CONTAINERS) containerCount = -1;
+  if (containerCount > 0) {
+    size_t len = prefs.getBytes("list", containers, sizeof(TareContainer) * containerCount);
+    if (len != sizeof(TareContainer) * containerCount) containerCount = -1;
+  }
+  prefs.end();
+
+  if (containerCount < 0) {
+    containerCount = sizeof(DEFAULT_CONTAINERS) / sizeof(DEFAULT_CONTAINERS[0]);
+    for (int i = 0; i < containerCount; i++) {
+      strlcpy(containers[i].name, DEFAULT_CONTAINERS[i], sizeof(containers[i].name));
+      containers[i].grams = 0.0f;
+    }
+    saveContainers();
+  }
+}
+
+// jméno z HTTP – bez uvozovek a řídicích znaků, ať nerozbije JSON
+void setContainerName(int idx, const String& name) {
+  size_t j = 0;
+  for (size_t i = 0; i < name.length() && j < sizeof(containers[idx].name) - 1; i++) {
+    char c = name[i];
+    if (c == '"' || c == '\\' || (uint8_t)c < 0x20) continue;
+    containers[idx].name[j++] = c;
+  }
+  containers[idx].name[j] = 0;
+}
+
+// -1 = sundat nádobu
+void applyContainer(int idx) {
+  if (idx < 0 || idx >= containerCount) {
+    activeContainer = -1;
+    weighing.setContainerTare(0);
+  } else {
+    activeContainer = idx;
+    weighing.setContainerTare(wpGramsToMg(containers[idx].grams));
+  }
+  currentWeightMg = weighing.totalMg;
+  stateVersion++;
+  mqttEvent("tare", idx >= 0 ? containers[idx].name : "");
+}
+
+int addContainer(const String& name, float grams) {
+  if (containerCount >= MAX_CONTAINERS) return -1;
+  int idx = containerCount++;
+  setContainerName(idx, name);
+  containers[idx].grams = grams;
+  saveContainers();
+  return idx;
+}
+
+bool deleteContainer(int idx) {
+  if (idx < 0 || idx >= containerCount) return false;
+  for (int i = idx; i < containerCount - 1; i++) containers[i] = containers[i + 1];
+  containerCount--;
+
+  if (activeContainer == idx)     applyContainer(-1);
+  else if (activeContainer > idx) activeContainer--;
+
+  // učení mazané nádoby se zruší, další se posunou s tabulkou
+  if (learnContainer == idx) {
+    Serial.println("[TARA] uceni zruseno – nadoba smazana");
+    learnContainer = -1;
+  } else if (learnContainer > idx) {
+    learnContainer--;
+  }
+  saveContainers();
+  return true;
+}
+
+void startContainerLearn(int idx) {
+  learnContainer    = idx;
+  learnStartMs      = millis();
+  learnStartGrossMg = weighing.grossMg;
+  learnChangeSeen   = false;
+  Serial.printf("[TARA] ucim nadobu '%s', cekam na ustaleni\n", containers[idx].name);
+}
+
+LearnResult processContainerLearn() {
+  if (learnContainer < 0) return LEARN_PENDING;
+
+  if (millis() - learnStartMs > LEARN_TIMEOUT_MS) {
+    Serial.println(learnChangeSeen ? "[TARA] uceni – timeout, vaha se neustalila"
+                                   : "[TARA] uceni – timeout, nadoba nepolozena");
+    learnContainer = -1;
+    return LEARN_TIMEOUT;
+  }
+
+  int32_t d = weighing.grossMg - learnStartGrossMg;
+  if (!learnChangeSeen) {
+    if (d < LEARN_CHANGE_MG && d > -LEARN_CHANGE_MG) return LEARN_PENDING;
+    learnChangeSeen = true;
+    learnStartMs    = millis();      // čas na ustálení běží od položení
+  }
+  if (!weighing.stable || weighing.grossMg < LEARN_MIN_MG) return LEARN_PENDING;
+
+  containers[learnContainer].grams = weighing.grossMg / 1000.0f;
+  saveContainers();
+  Serial.printf("[TARA] '%s' = %s g\n", containers[learnContainer].name, weightText(weighing.grossMg).c_str());
+  applyContainer(learnContainer);
+  learnContainer = -1;
+  return LEARN_DONE;
+}
+
+// ========================
+// Potraviny (databáze ve flash)
+// ========================
+// Obraz z tools/mkfooddb.cpp v oddílu "fooddb" – jen se namapuje,
+// záznamy se čtou přímo z flash a do RAM se nic nekopíruje.
+const esp_partition_subtype_t FOOD_DB_SUBTYPE = (esp_partition_subtype_t)0x40;
+
+FoodDb foodDb;
+esp_partition_mmap_handle_t foodDbMap;
+const FoodRecord* currentFood = nullptr;   // nullptr = volný text v currentItem
+
+struct Nutrition {
+  float kcal;
+  float protein;
+  float carbs;
+  float fat;
+};
+
+void openFoodDb() {
+  const esp_partition_t* part =
+      esp_partition_find_first(ESP_PARTITION_TYPE_DATA, FOOD_DB_SUBTYPE, "fooddb");
+  if (!part) {
+    Serial.println("[FOOD] oddil fooddb chybi");
+    return;
+  }
+
+  FoodDbHeader hdr;
+  if (esp_partition_read(part, 0, &hdr, sizeof(hdr)) != ESP_OK ||
+      hdr.magic != FOOD_DB_MAGIC || hdr.imageSize > part->size) {
+    Serial.println("[FOOD] oddil fooddb je prazdny");
+    return;
+  }
+
+  const void* ptr;
+  if (esp_partition_mmap(part, 0, hdr.imageSize, ESP_PARTITION_MMAP_DATA, &ptr, &foodDbMap) != ESP_OK) {
+    Serial.println("[FOOD] mmap selhal");
+    return;
+  }
+  if (!foodDb.open((const uint8_t*)ptr, hdr.imageSize)) {
+    Serial.println("[FOOD] poskozeny obraz databaze");
+    esp_partition_munmap(foodDbMap);
+    return;
+  }
+  Serial.printf("[FOOD] %u potravin\n", (unsigned)foodDb.count());
+}
+
+// hodnoty v záznamu jsou na 100 g ×10
+Nutrition nutritionFor(const FoodRecord* f, int32_t mg) {
+  Nutrition n = {0, 0, 0, 0};
+  if (!f || mg <= 0) return n;
+  float k = mg / 1000000.0f;   // hodnoty jsou ×10 na 100 g
+  n.kcal    = f->kcal * k;
+  n.protein = f->protein * k;
+  n.carbs   = f->carbs * k;
+  n.fat     = f->fat * k;
+  return n;
+}
+
+void selectFood(const FoodRecord* f) {
+  currentFood = f;
+  if (f) {
+    currentItem = foodDb.name(f);
+    mqttSetItem(currentItem);
+    setDynamicMode(false);
+    Serial.printf("[FOOD] vybrano %u %s\n", (unsigned)f->id, foodDb.name(f));
+  } else {
+    currentItem = "Nic";
+    mqttSetItem(currentItem);
+  }
+  lastDrawnWeightMg = WEIGHT_NONE;  // překreslit i řádek s kcal
+  stateVersion++;
+}
+
+// ========================
+// Rotary enkoder
+// ========================
+void updateEncoder() {
+  encoder.update(digitalRead(ENC_A) == HIGH, digitalRead(ENC_B) == HIGH, millis());
+}
+
+// ========================
+// HUD – statická část
+// ========================
+void drawTopBarGradient() {
+  // jednoduchý vertikální "glow" gradient
+  for (int y = 0; y < 24; y++) {
+    uint8_t mix = map(y, 0, 23, 0, 255);
+    uint8_t r1 = (COLOR_TOPBAR1 >> 11) & 0x1F;
+    uint8_t g1 = (COLOR_TOPBAR1 >> 5)  & 0x3F;
+    uint8_t b1 = (COLOR_TOPBAR1)       & 0x1F;
+
+    uint8_t r2 = (COLOR_TOPBAR2 >> 11) & 0x1F;
+    uint8_t g2 = (COLOR_TOPBAR2 >> 5)  & 0x3F;
+    uint8_t b2 = (COLOR_TOPBAR2)       & 0x1F;
+
+    uint8_t r = (r1 * (255 - mix) + r2 * mix) / 255;
+    uint8_t g = (g1 * (255 - mix) + g2 * mix) / 255;
+    uint8_t b = (b1 * (255 - mix) + b2 * mix) / 255;
+
+    uint16_t c = (r << 11) | (g << 5) | b;
+    tft.drawFastHLine(0, y, 320, c);
+  }
+}
+
+void drawStaticHUD() {
+  tft.fillScreen(COLOR_BG);
+
+  // top bar
+  drawTopBarGradient();
+
+  // "Chytra vaha" label vlevo nahoře
+  tft.setTextColor(COLOR_TEXT);
+  tft.setTextSize(1);
+  tft.setCursor(4, 6);
+  tft.print("Chytra vaha");
+
+  int boxX = 20;
+  int boxY = 60;
+  int boxW = 280;
+  int boxH = 120;
+
+  uint16_t glowColor = COLOR_TOPBAR2;
+  tft.fillRoundRect(boxX - 4, boxY - 4, boxW + 8, boxH + 8, 14, glowColor);
+  tft.fillRoundRect(boxX, boxY, boxW, boxH, 12, COLOR_BG);
+
+  // label "g"
+  tft.setTextSize(2);
+  tft.setCursor(boxX + boxW - 35, boxY + boxH - 28);
+  tft.setTextColor(COLOR_ACCENT);
+  tft.print("g");
+
+  // spodní status bar (enkoder / stav tlačítka)
+  tft.drawFastHLine(0, 220, 320, COLOR_TOPBAR2);
+}
+
+void eraseWeightArea() {
+  // smažeme jen oblast, kde je číslo
+  int boxX = 20;
+  int boxY = 60;
+  int boxW = 280;
+  int boxH = 120;
+  // uvnitř ještě menší rect pro číslo
+  tft.fillRect(boxX + 10, boxY + 20, boxW - 60, boxH - 40, COLOR_BG);
+}
+
+// ========================
+// HUD – dynamická část
+// ========================
+
+// ikona WiFi podle síly
+void drawWifiIcon(int level) {
+  // úroveň 0–4 (0 = nic, 4 = plný)
+  int x = 260;
+  int y = 5;
+  int barW = 5;
+  int barSpacing = 3;
+
+  // smaž ikonku
+  tft.fillRect(x - 2, 2, 320 - x, 20, COLOR_BG);
+  // malý "glow" pod tím
+  tft.fillRect(x - 2, 20, 40, 2, COLOR_TOPBAR2);
+
+  for (int i = 0; i < 4; i++) {
+    int barH = 4 + i * 3;
+    int bx = x + i * (barW + barSpacing);
+    int by = 20 - barH;
+    uint16_t col = (i < level) ? COLOR_ACCENT : 0x4208;
+    tft.fillRect(bx, by, barW, barH, col);
+  }
+}
+
+int wifiLevelFromRSSI(int rssi) {
+  if (rssi == 0) return 0;
+  if (rssi > -55) return 4;
+  if (rssi > -65) return 3;
+  if (rssi > -75) return 2;
+  if (rssi > -85) return 1;
+  return 0;
+}
+
+bool updateTopBarHUD() {
+  bool drawn = false;
+
+  // čas + datum – jen když hodiny tikly
+  ClockText ct;
+  uint32_t clockVer = clockRead(ct);
+
+  if (clockVer != lastDrawnClock) {
+    // smažeme střed top baru (pod textem) – necháme gradient pod tím
+    tft.fillRect(110, 4, 130, 18, COLOR_BG);  // malý "průhled" – přes něj text
+    tft.setTextSize(1);
+    tft.setTextColor(COLOR_TEXT);
+    tft.setCursor(115, 6);
+    tft.print(ct.time);
+    tft.setCursor(115, 14);
+    tft.print(ct.date);
+
+    lastDrawnClock = clockVer;
+    drawn = true;
+  }
+
+  // WiFi síla – RSSI stačí číst jednou za sekundu, ne v každém snímku
+  if (lastWifiLevel >= 0 && millis() - lastRssiMs < 1000) {
+    return drawn;
+  }
+  lastRssiMs = millis();
+
+  int rssi = 0;
+  int level = 0;
+  if (WiFi.status() == WL_CONNECTED) {
+    rssi = WiFi.RSSI();
+    level = wifiLevelFromRSSI(rssi);
+  } else {
+    level = 0;
+  }
+
+  if (level != lastWifiLevel) {
+    drawWifiIcon(level);
+    lastWifiLevel = level;
+    drawn = true;
+  }
+  return drawn;
+}
+
+bool updateWeightHUD() {
+  int32_t w = wpRoundMg(displayWeightMg(), WEIGHT_DECIMALS);
+
+  // jen když se změnila zobrazená hodnota
+  if (w == lastDrawnWeightMg) {
+    return false;
+  }
+
+  eraseWeightArea();
+
+  // velké číslo – tady by šel použít Orbitron jako vlastní font,
+  // pro teď použijeme default s větším textSize
+  tft.setTextColor(COLOR_TEXT);
+  tft.setTextSize(4);
+
+  char buf[16];
+  int len = wpFormatMg(w, WEIGHT_DECIMALS, buf);
+
+  // spočítáme šířku textu nahrubo (4 px * size + mezery)
+  int charW = 6 * 4; // 6px * size4
+  int totalW = len * charW;
+
+  int boxX = 20;
+  int boxW = 280;
+  int x = boxX + (boxW - totalW) / 2;
+  int y = 90;
+
+  // "glow" – nejdřív tmavší stín
+  tft.setTextColor(COLOR_TOPBAR2);
+  tft.setCursor(x + 2, y + 2);
+  tft.print(buf);
+
+  // pak ostrý text
+  tft.setTextColor(COLOR_TEXT);
+  tft.setCursor(x, y);
+  tft.print(buf);
+
+  // kcal a makra pro vybranou potravinu (B = bílkoviny, S = sacharidy, T = tuky)
+  if (currentFood) {
+    Nutrition n = nutritionFor(currentFood, w);
+    char line[40];
+    snprintf(line, sizeof(line), "%.0f kcal  B%.1f S%.1f T%.1f",
+             n.kcal, n.protein, n.carbs, n.fat);
+    tft.setTextSize(1);
+    tft.setTextColor(COLOR_ACCENT);
+    tft.setCursor(boxX + 10, 142);
+    tft.print(line);
+  }
+
+  lastDrawnWeightMg = w;
+  return true;
+}
+
+// stav dynamického vážení vlevo nahoře v rámečku
+bool updateDynamicHUD() {
+  int st = dynamicMode ? (int)dynWeigher.getState() : -2;
+  if (st == lastDrawnDynState) return false;
+
+  int boxX = 20;
+  int boxY = 60;
+  tft.fillRect(boxX + 10, boxY + 6, 120, 10, COLOR_BG);
+  if (dynamicMode) {
+    tft.setTextSize(1);
+    tft.setCursor(boxX + 10, boxY + 8);
+    if (st == DW_HELD) {
+      tft.setTextColor(COLOR_ACCENT);
+      tft.print("DYN: HOLD");
+    } else if (st == DW_MEASURING) {
+      tft.setTextColor(COLOR_MENU2_ACCENT);
+      tft.print("DYN: mereni...");
+    } else {
+      tft.setTextColor(COLOR_TEXT);
+      tft.print("DYN: prazdno");
+    }
+  }
+  lastDrawnDynState = st;
+  return true;
+}
+
+// aktivní nádoba vpravo nahoře v rámečku
+bool updateTareHUD() {
+  if (activeContainer == lastDrawnContainer) return false;
+
+  int boxX = 20;
+  int boxY = 60;
+  tft.fillRect(boxX + 140, boxY + 6, 130, 10, COLOR_BG);
+  if (activeContainer >= 0) {
+    char buf[22];
+    snprintf(buf, sizeof(buf), "T: %s", containers[activeContainer].name);
+    tft.setTextSize(1);
+    tft.setTextColor(COLOR_MENU_TARE_ACCENT);
+    tft.setCursor(boxX + 140, boxY + 8);
+    tft.print(buf);
+  }
+  lastDrawnContainer = activeContainer;
+  return true;
+}
+
+// zóny dole v rámečku váhy – jen když jich je víc
+bool updateZonesHUD() {
+  if (ZONE_COUNT < 2) return false;
+
+  bool changed = false;
+  for (int z = 0; z < ZONE_COUNT; z++) {
+    if (wpRoundMg(weighing.zoneMg[z], WEIGHT_DECIMALS) != lastDrawnZoneMg[z]) changed = true;
+  }
+  if (!changed) return false;
+
+  int boxX = 20;
+  int boxY = 60;
+  int boxH = 120;
+  tft.fillRect(boxX + 10, boxY + boxH - 18, 220, 10, COLOR_BG);
+  tft.setTextSize(1);
+  tft.setTextColor(COLOR_ACCENT);
+  tft.setCursor(boxX + 10, boxY + boxH - 16);
+
+  for (int z = 0; z < ZONE_COUNT; z++) {
+    char buf[16];
+    wpFormatMg(weighing.zoneMg[z], WEIGHT_DECIMALS, buf);
+    tft.print("Z");
+    tft.print(z + 1);
+    tft.print(": ");
+    tft.print(buf);
+    tft.print("  ");
+    lastDrawnZoneMg[z] = wpRoundMg(weighing.zoneMg[z], WEIGHT_DECIMALS);
+  }
+  return true;
+}
+
+// trend pod rámečkem – dokreslí jen nové sloupce
+int trendY(int32_t mg) {
+  int64_t span = (int64_t)trendHi - trendLo;
+  int64_t off  = ((int64_t)mg - trendLo) * (TREND_H - 1);
+  int y = TREND_Y + TREND_H - 1 - (int)((off + span / 2) / span);
+  if (y < TREND_Y) y = TREND_Y;
+  if (y > TREND_Y + TREND_H - 1) y = TREND_Y + TREND_H - 1;
+  return y;
+}
+
+void drawTrendColumn(int i) {
+  int x = TREND_X + i;
+  const TrendColumn& c = trendCols[i];
+  tft.drawFastVLine(x, TREND_Y, TREND_H, COLOR_BG);
+  if (!c.valid) return;
+
+  // značky tolerance ustálení kolem hodnoty – dokud se čára drží mezi
+  // nimi, váha je v prahu stableThresholdMg
+  int32_t mid = c.lo + (c.hi - c.lo) / 2;
+  tft.drawPixel(x, trendY(mid + weighing.stableThresholdMg), COLOR_TOPBAR2);
+  tft.drawPixel(x, trendY(mid - weighing.stableThresholdMg), COLOR_TOPBAR2);
+
+  int yTop = trendY(c.hi);
+  int yBot = trendY(c.lo);
+  tft.drawFastVLine(x, yTop, yBot - yTop + 1, c.stable ? COLOR_ACCENT : COLOR_MENU2_ACCENT);
+}
+
+bool updateTrendHUD() {
+  if (!trendFullRedraw && trendPending == 0) return false;
+
+  if (trendFullRedraw) {
+    for (int i = 0; i < TREND_W; i++) drawTrendColumn(i);
+  } else {
+    for (; trendPending > 0; trendPending--) {
+      drawTrendColumn((trendHead - trendPending + TREND_W) % TREND_W);
+    }
+  }
+  trendPending    = 0;
+  trendFullRedraw = false;
+
+  // kurzor na místě dalšího sloupce (přepisuje nejstarší data)
+  tft.drawFastVLine(TREND_X + trendHead, TREND_Y, TREND_H, COLOR_TOPBAR2);
+  return true;
+}
+
+bool updateBottomHUD() {
+  int btn = button.pressed() ? 1 : 0;
+  if (encoder.position() == lastDrawnEnc && btn == lastDrawnBtn) return false;
+
+  // encoder info dole
+  tft.fillRect(0, 222, 320, 18, COLOR_BG);
+  tft.setTextSize(1);
+  tft.setTextColor(COLOR_TEXT);
+  tft.setCursor(4, 224);
+  tft.print("ENC: ");
+  tft.print(encoder.position());
+
+  tft.setCursor(120, 224);
+  tft.print("BTN: ");
+  tft.print(btn ? "PRESS" : "----");
+
+  lastDrawnEnc = encoder.position();
+  lastDrawnBtn = btn;
+  return true;
+}
+
+// hmotnost, kterou právě ukazuje rámeček váhy (recept: jen aktuální krok)
+int32_t hudWeightMg() {
+  if (recipeMode && recipe.running()) return recipe.stepMg();
+  return displayWeightMg();
+}
+
+// recept – krok, jeho hmotnost a pruhy ingrediencí v rámečku váhy
+const int RECIPE_ROWS  = 4;
+const int RECIPE_ROW_Y = 108;
+const int RECIPE_ROW_H = 14;
+const int RECIPE_BAR_X = 130;
+const int RECIPE_BAR_W = 120;   // vpravo dole je ještě popisek "g"
+
+// první zobrazený krok – aktuální na druhém řádku
+int recipeFirstRow() {
+  int first = recipe.currentStep() - 1;
+  if (first > recipe.stepCount() - RECIPE_ROWS) first = recipe.stepCount() - RECIPE_ROWS;
+  return first < 0 ? 0 : first;
+}
+
+// šířka pruhu v px; 100 % = celý pruh, převažek se ukáže barvou
+int recipeBarPx(int i) {
+  int pm = recipe.progressPermille(i);
+  return (pm > 1000 ? 1000 : pm) * (RECIPE_BAR_W - 2) / 1000;
+}
+
+uint16_t recipeBarColor(int i) {
+  const RecipeStep& st = recipe.step(i);
+  int32_t v = i < recipe.currentStep() ? st.actualMg : recipe.stepMg();
+  if (v > st.targetMg + st.tolMg) return COLOR_MENU_TARE_ACCENT;   // převažek
+  if (v >= st.targetMg - st.tolMg) return COLOR_ACCENT;            // v toleranci
+  return COLOR_TOPBAR2;
+}
+
+void drawRecipeBar(int i, int y) {
+  int px = recipeBarPx(i);
+  tft.drawRect(RECIPE_BAR_X, y, RECIPE_BAR_W, 9, i == recipe.currentStep() ? COLOR_TEXT : COLOR_TOPBAR2);
+  tft.fillRect(RECIPE_BAR_X + 1, y + 1, px, 7, recipeBarColor(i));
+  tft.fillRect(RECIPE_BAR_X + 1 + px, y + 1, RECIPE_BAR_W - 2 - px, 7, COLOR_BG);
+}
+
+void drawRecipeRows() {
+  int first = recipeFirstRow();
+  tft.fillRect(30, RECIPE_ROW_Y, 260, RECIPE_ROWS * RECIPE_ROW_H, COLOR_BG);
+  tft.setTextSize(1);
+  for (int r = 0; r < RECIPE_ROWS && first + r < recipe.stepCount(); r++) {
+    int i = first + r;
+    int y = RECIPE_ROW_Y + r * RECIPE_ROW_H;
+    tft.setTextColor(i == recipe.currentStep() ? COLOR_TEXT : (i < recipe.currentStep() ? COLOR_ACCENT : COLOR_TOPBAR2));
+    tft.setCursor(30, y + 1);
+    char line[24];
+    snprintf(line, sizeof(line), "%c %.14s", i < recipe.currentStep() ? '*' : ' ', recipe.step(i).name);
+    tft.print(line);
+    drawRecipeBar(i, y);
+  }
+}
+
+bool updateRecipeHUD() {
+  int cur = recipe.currentStep();
+  int32_t w = wpRoundMg(hudWeightMg(), WEIGHT_DECIMALS);
+  int bar = recipe.running() ? recipeBarPx(cur) : -1;
+
+  if (cur == lastDrawnRecipeStep && w == lastDrawnWeightMg && bar == lastDrawnRecipeBar) {
+    return false;
+  }
+
+  int boxX = 20;
+  int boxY = 60;
+  char line[40];
+
+  // nový krok = celý obsah rámečku znovu
+  if (cur != lastDrawnRecipeStep) {
+    tft.fillRect(boxX + 10, boxY + 6, 120, 10, COLOR_BG);
+    tft.setTextSize(1);
+    tft.setTextColor(COLOR_ACCENT);
+    tft.setCursor(boxX + 10, boxY + 8);
+    if (recipe.running()) {
+      snprintf(line, sizeof(line), "KROK %d/%d", cur + 1, recipe.stepCount());
+    } else {
+      strlcpy(line, "RECEPT HOTOV", sizeof(line));
+    }
+    tft.print(line);
+    drawRecipeRows();
+  } else if (recipe.running()) {
+    drawRecipeBar(cur, RECIPE_ROW_Y + (cur - recipeFirstRow()) * RECIPE_ROW_H);
+  }
+
+  // hmotnost kroku / cíl
+  tft.fillRect(boxX + 10, boxY + 20, 260, 26, COLOR_BG);
+  tft.setTextSize(3);
+  tft.setTextColor(COLOR_TEXT);
+  tft.setCursor(boxX + 10, boxY + 22);
+  if (recipe.running()) {
+    snprintf(line, sizeof(line), "%s/%s", weightText(w).c_str(), weightText(recipe.step(cur).targetMg).c_str());
+  } else {
+    snprintf(line, sizeof(line), "%s g", weightText(w).c_str());
+  }
+  tft.print(line);
+
+  lastDrawnRecipeStep = cur;
+  lastDrawnRecipeBar  = bar;
+  lastDrawnWeightMg   = w;
+  return true;
+}
+
+// počítání kusů – v rámečku váhy místo gramů
+bool updateCountHUD() {
+  int st = (int)pieceCounter.getState();
+  int32_t w = wpRoundMg(currentWeightMg, WEIGHT_DECIMALS);
+  int count = currentPieceCount();
+  bool ok = st == PC_COUNTING && pieceCounter.reliable(count);
+
+  if (st == lastDrawnCountState && count == lastDrawnCount && ok == lastDrawnCountOk &&
+      w == lastDrawnWeightMg) {
+    return false;
+  }
+
+  int boxX = 20;
   int boxY = 60;
   int boxW = 280;
   int boxH = 120;
-  // uvnitř ještě menší rect pro číslo
-  tft.fillRect(boxX + 10, boxY + 20, boxW - 60, boxH - 40, COLOR_BG);
+
+  // "ks" místo "g" – jen poprvé, pak zůstává
+  if (lastDrawnCountState < 0) {
+    tft.fillRect(boxX + boxW - 40, boxY + boxH - 30, 34, 18, COLOR_BG);
+    tft.setTextSize(2);
+    tft.setTextColor(COLOR_ACCENT);
+    tft.setCursor(boxX + boxW - 35, boxY + boxH - 28);
+    tft.print("ks");
+  }
+
+  // stav vlevo nahoře v rámečku
+  char line[40];
+  tft.fillRect(boxX + 10, boxY + 6, 120, 10, COLOR_BG);
+  tft.setTextSize(1);
+  tft.setCursor(boxX + 10, boxY + 8);
+  if (st == PC_COUNTING && !ok) {
+    tft.setTextColor(COLOR_MENU_TARE_ACCENT);
+    tft.print("MALE ROZLISENI");
+  } else {
+    tft.setTextColor(COLOR_ACCENT);
+    tft.print(st == PC_ZERO ? "KS: nula..." : (st == PC_REFERENCE ? "KS: vzorek..." : "KS: pocitani"));
+  }
+
+  eraseWeightArea();
+  tft.setTextColor(COLOR_TEXT);
+  if (st == PC_ZERO) {
+    tft.setTextSize(2);
+    tft.setCursor(boxX + 20, 100);
+    tft.print("Vyprazdni vahu");
+  } else if (st == PC_REFERENCE) {
+    snprintf(line, sizeof(line), "Poloz %d ks", pieceCounter.getRefPieces());
+    tft.setTextSize(3);
+    tft.setCursor(boxX + 20, 96);
+    tft.print(line);
+  } else {
+    snprintf(line, sizeof(line), "%d", count);
+    int x = boxX + (boxW - (int)strlen(line) * 6 * 4) / 2;
+    tft.setTextSize(4);
+    tft.setTextColor(ok ? COLOR_TEXT : COLOR_MENU_TARE_ACCENT);
+    tft.setCursor(x, 90);
+    tft.print(line);
+
+    // gramy a mez spolehlivosti pod počtem
+    snprintf(line, sizeof(line), "%s g   spolehlive do %d ks", weightText(w).c_str(),
+             pieceCounter.maxReliable());
+    tft.setTextSize(1);
+    tft.setTextColor(COLOR_ACCENT);
+    tft.setCursor(boxX + 10, 142);
+    tft.print(line);
+  }
+
+  lastDrawnCountState = st;
+  lastDrawnCount      = count;
+  lastDrawnCountOk    = ok;
+  lastDrawnWeightMg   = w;
+  return true;
+}
+
+// ---- kontrolní vážení – verdikt přes celou plochu ----
+
+uint16_t checkVerdictColor(CheckVerdict v) {
+  switch (v) {
+    case CV_PASS:      return COLOR_ACCENT;        // zelená
+    case CV_UNDER:     return COLOR_MENU2_ACCENT;  // žlutá
+    case CV_OVER:      return COLOR_MENU_TARE_ACCENT; // červená
+    case CV_UNSETTLED: return 0xFD20;              // oranžová
+    default:           return COLOR_BG;
+  }
+}
+
+const char* checkVerdictLabel(CheckVerdict v) {
+  switch (v) {
+    case CV_PASS:      return "OK";
+    case CV_UNDER:     return "MALO";
+    case CV_OVER:      return "MOC";
+    case CV_UNSETTLED: return "NESTABILNI";
+    default:           return "PRIPRAVENO";
+  }
+}
+
+void drawCenteredText(const char* txt, int size, int y) {
+  int x = (320 - (int)strlen(txt) * 6 * size) / 2;
+  tft.setTextSize(size);
+  tft.setCursor(x < 0 ? 0 : x, y);
+  tft.print(txt);
+}
+
+void drawCheckVerdict() {
+  CheckVerdict v = checkWeigher.getVerdict();
+  const CheckWeighParams& p = checkWeigher.getParams();
+  uint16_t bg = checkVerdictColor(v);
+  uint16_t fg = v == CV_NONE ? COLOR_TEXT : COLOR_BG;
+
+  tft.fillRect(0, 24, 320, 198, bg);
+  tft.setTextColor(fg);
+
+  const char* label = checkVerdictLabel(v);
+  drawCenteredText(label, strlen(label) * 36 <= 300 ? 6 : 4, 44);
+
+  char line[40];
+  if (v == CV_NONE) {
+    snprintf(line, sizeof(line), "cil %s g", weightText(p.targetMg).c_str());
+    drawCenteredText(line, 3, 120);
+  } else {
+    snprintf(line, sizeof(line), "%s g", weightText(checkWeigher.getLastMg()).c_str());
+    drawCenteredText(line, 4, 112);
+    int32_t dev = checkWeigher.getLastMg() - p.targetMg;
+    snprintf(line, sizeof(line), "%s%s g", dev >= 0 ? "+" : "", weightText(dev).c_str());
+    drawCenteredText(line, 2, 160);
+  }
+  snprintf(line, sizeof(line), "tolerance -%s / +%s g",
+           weightText(p.underMg).c_str(), weightText(p.overMg).c_str());
+  drawCenteredText(line, 1, 184);
+}
+
+// stav kusu dole ve verdiktu (barva pozadí podle posledního verdiktu)
+void drawCheckState() {
+  CheckVerdict v = checkWeigher.getVerdict();
+  tft.fillRect(0, 200, 320, 16, checkVerdictColor(v));
+  tft.setTextColor(v == CV_NONE ? COLOR_TEXT : COLOR_BG);
+  switch (checkWeigher.getState()) {
+    case CW_SETTLING: drawCenteredText("VAZIM...", 2, 200); break;
+    case CW_DONE:     drawCenteredText("SUNDEJ", 2, 200); break;
+    default:          break;
+  }
+}
+
+// počty a propustnost místo řádku enkodéru
+void drawCheckStats() {
+  const CheckWeighStats& st = checkWeigher.getStats();
+  char line[64];
+  snprintf(line, sizeof(line), "n %u  OK %u  -%u  +%u  ?%u  %.1f/min  sd %.2f g",
+           (unsigned)st.total, (unsigned)st.pass, (unsigned)st.under, (unsigned)st.over,
+           (unsigned)st.unsettled, checkWeigher.itemsPerMinute(esp_timer_get_time()),
+           checkWeigher.stddevMg() / 1000.0);
+  tft.fillRect(0, 222, 320, 18, COLOR_BG);
+  tft.setTextSize(1);
+  tft.setTextColor(COLOR_TEXT);
+  tft.setCursor(4, 226);
+  tft.print(line);
+}
+
+bool updateCheckHUD() {
+  uint32_t total = checkWeigher.getStats().total;
+  int st = (int)checkWeigher.getState();
+  bool drawn = false;
+
+  if (total != lastDrawnCheckTotal) {
+    drawCheckVerdict();
+    drawCheckState();
+    drawCheckStats();
+    lastDrawnCheckTotal = total;
+    lastDrawnCheckState = st;
+    lastCheckStatsMs    = millis();
+    return true;
+  }
+  if (st != lastDrawnCheckState) {
+    drawCheckState();
+    lastDrawnCheckState = st;
+    drawn = true;
+  }
+  // propustnost v klidu klesá – stačí jednou za sekundu
+  if (millis() - lastCheckStatsMs >= 1000) {
+    drawCheckStats();
+    lastCheckStatsMs = millis();
+    drawn = true;
+  }
+  return drawn;
+}
+
+// ========================
+// Seznam – navigace a kreslení
+// ========================
+void listInvalidate(ListView& lv) {
+  for (int s = 0; s < LIST_ROWS; s++) lv.drawnItem[s] = -2;
+  lv.drawnTop = -1;
+}
+
+void listBegin(ListView& lv, int count, uint16_t accent,
+               void (*label)(int, char*, size_t),
+               bool (*marked)(int) = nullptr,
+               int (*jump)(int, int) = nullptr) {
+  lv.count   = count < 1 ? 1 : count;
+  lv.index   = 0;
+  lv.top     = 0;
+  lv.accent  = accent;
+  lv.label   = label;
+  lv.marked  = marked;
+  lv.jump    = jump;
+  lv.encLast = encoder.position();
+  listInvalidate(lv);
+}
+
+// výběr na idx, okno se posune jen o tolik, aby byl výběr vidět
+void listScrollTo(ListView& lv, int idx) {
+  lv.scrollTo(idx, LIST_ROWS);
+}
+
+// změna počtu položek (např. nová nádoba) – vše se překreslí
+void listSetCount(ListView& lv, int count) {
+  lv.setCount(count, LIST_ROWS);
+  listInvalidate(lv);
+}
+
+// kroky enkodéru -> pohyb výběru (akcelerace / skoky po písmenech)
+void listNavigate(ListView& lv) {
+  long d = encoder.position() - lv.encLast;
+  if (d == 0) return;
+  lv.encLast = encoder.position();
+
+  bool jump = lv.jump && encoder.fastSpin(millis());
+  lv.navigate(d, encoder.accelFactor(lv.count, millis()), jump ? lv.jump : nullptr, LIST_ROWS);
+}
+
+void listDrawRow(ListView& lv, int slot, int item, bool selected) {
+  int lineH = 24;
+  int y = 40 + slot * lineH;
+
+  if (item >= lv.count) {
+    tft.fillRect(10, y - 2, 300, lineH, COLOR_BG);
+    return;
+  }
+
+  if (selected) {
+    tft.fillRoundRect(10, y - 2, 300, lineH, 8, lv.accent);
+    tft.setTextColor(COLOR_BG);
+  } else {
+    tft.fillRoundRect(10, y - 2, 300, lineH, 8, COLOR_BG);
+    tft.drawRoundRect(10, y - 2, 300, lineH, 8, lv.accent);
+    // aktivní položka má zdvojený rámeček i bez výběru
+    if (lv.marked && lv.marked(item)) tft.drawRoundRect(11, y - 1, 298, lineH - 2, 7, lv.accent);
+    tft.setTextColor(COLOR_TEXT);
+  }
+
+  char buf[28];
+  lv.label(item, buf, sizeof(buf));
+  tft.setTextSize(2);
+  tft.setCursor(20, y + 2);
+  tft.print(buf);
+}
+
+void listDrawScrollbar(ListView& lv) {
+  int trackY = 38;
+  int trackH = LIST_ROWS * 24;
+  tft.fillRect(313, trackY, 4, trackH, COLOR_BG);
+  if (lv.count <= LIST_ROWS) return;
+
+  int thumbH = trackH * LIST_ROWS / lv.count;
+  if (thumbH < 6) thumbH = 6;
+  int thumbY = trackY + (trackH - thumbH) * lv.top / (lv.count - LIST_ROWS);
+  tft.fillRect(313, thumbY, 4, thumbH, lv.accent);
+}
+
+// překreslí max LIST_ROW_BUDGET slotů, které neodpovídají stavu;
+// nejdřív slot s výběrem, aby odezva na otočení byla hned vidět
+void listRender(ListView& lv) {
+  WdStage st(WD_LOOP, ST_MENU);
+  int budget = LIST_ROW_BUDGET;
+  int selSlot = lv.index - lv.top;
+
+  for (int n = 0; n < LIST_ROWS && budget > 0; n++) {
+    int slot = (selSlot + n) % LIST_ROWS;
+    int item = lv.top + slot;
+    bool sel = (item == lv.index);
+    if (lv.drawnItem[slot] == item && lv.drawnSel[slot] == sel) continue;
+
+    listDrawRow(lv, slot, item, sel);
+    lv.drawnItem[slot] = item;
+    lv.drawnSel[slot]  = sel;
+    budget--;
+  }
+
+  if (budget > 0 && lv.drawnTop != lv.top) {
+    listDrawScrollbar(lv);
+    lv.drawnTop = lv.top;
+  }
+}
+
+void drawListHint(const char* txt) {
+  tft.fillRect(0, 222, 320, 18, COLOR_BG);
+  tft.setTextSize(1);
+  tft.setTextColor(COLOR_TEXT);
+  tft.setCursor(4, 224);
+  tft.print(txt);
+}
+
+// ========================
+// MENU – kreslení
+// ========================
+void mainMenuLabel(int index, char* buf, size_t len) {
+  strlcpy(buf, MENU_LABELS[index], len);
+}
+
+void drawMenuScreen() {
+  tft.fillScreen(COLOR_BG);
+
+  // top bar znovu použijeme jako header menu
+  drawTopBarGradient();
+  tft.setTextColor(COLOR_TEXT);
+  tft.setTextSize(1);
+  tft.setCursor(4, 6);
+  tft.print("Menu");
+
+  listInvalidate(mainMenu);
+  drawListHint("Otacej pro vyber, stisk pro potvrzeni");
+}
+
+// ---- TARE menu (červené) ----
+
+int tareMenuCount() {
+  return containerCount + 3;
+}
+
+void tareMenuLabel(int index, char* buf, size_t len) {
+  if (index == 0) {
+    strlcpy(buf, "Zpet", len);
+  } else if (index == 1) {
+    strlcpy(buf, "Bez nadoby", len);
+  } else if (index == tareMenuCount() - 1) {
+    strlcpy(buf, "+ Nova nadoba", len);
+  } else {
+    const TareContainer& c = containers[index - 2];
+    if (c.grams > 0.0f) snprintf(buf, len, "%-16.16s%5.0fg", c.name, c.grams);
+    else                snprintf(buf, len, "%-16.16s  ???", c.name);
+  }
+}
+
+bool tareMenuMarked(int index) {
+  return (index - 2 == activeContainer && activeContainer >= 0) ||
+         (index == 1 && activeContainer < 0);
+}
+
+// počet položek se mění s tabulkou nádob
+void drawTareMenuRows() {
+  listSetCount(tareMenu, tareMenuCount());
+}
+
+void drawTareMenuHint(const char* txt) {
+  drawListHint(txt);
 }
 
-// ========================
-// HUD – dynamická část
-// ========================
+void drawTareMenuScreen() {
+  tft.fillScreen(COLOR_BG);
+
+  // top bar v červené
+  tft.fillRect(0, 0, 320, 24, COLOR_MENU_TARE_ACCENT);
+  tft.setTextColor(COLOR_BG);
+  tft.setTextSize(1);
+  tft.setCursor(4, 6);
+  tft.print("Nadoba / miska");
 
-// ikona WiFi podle síly
-void drawWifiIcon(int level) {
-  // úroveň 0–4 (0 = nic, 4 = plný)
-  int x = 260;
-  int y = 5;
-  int barW = 5;
-  int barSpacing = 3;
+  drawTareMenuRows();
+  drawTareMenuHint("Otacej, stisk = vybrat, dlouze = naucit");
+}
 
-  // smaž ikonku
-  tft.fillRect(x - 2, 2, 320 - x, 20, COLOR_BG);
-  // malý "glow" pod tím
-  tft.fillRect(x - 2, 20, 40, 2, COLOR_TOPBAR2);
+// ---- MENU2 (žluté) – potraviny ----
 
-  for (int i = 0; i < 4; i++) {
-    int barH = 4 + i * 3;
-    int bx = x + i * (barW + barSpacing);
-    int by = 20 - barH;
-    uint16_t col = (i < level) ? COLOR_ACCENT : 0x4208;
-    tft.fillRect(bx, by, barW, barH, col);
+void foodMenuLabel(int index, char* buf, size_t len) {
+  if (index == 0) {
+    strlcpy(buf, foodDb.count() ? "Zpet" : "Zpet (databaze chybi)", len);
+    return;
   }
+  // 23 znaků velikosti 2 se vejde do řádku
+  snprintf(buf, len, "%.23s", foodDb.name(foodDb.byNamePos(index - 1)));
 }
 
-int wifiLevelFromRSSI(int rssi) {
-  if (rssi == 0) return 0;
-  if (rssi > -55) return 4;
-  if (rssi > -65) return 3;
-  if (rssi > -75) return 2;
-  if (rssi > -85) return 1;
+// typeahead: skok na první potravinu dalšího / předchozího písmene
+int foodMenuJump(int index, int dir) {
+  if (index == 0) return dir > 0 ? 1 : 0;
+
+  uint32_t pos = index - 1;
+  int b = FoodDb::bucketOf(foodDb.name(foodDb.byNamePos(pos))[0]);
+
+  if (dir > 0) {
+    for (int nb = b + 1; nb < FOOD_DB_BUCKETS; nb++) {
+      if (foodDb.bucketBegin(nb) < foodDb.bucketBegin(nb + 1)) return foodDb.bucketBegin(nb) + 1;
+    }
+    return foodDb.count();
+  }
+
+  if (pos > foodDb.bucketBegin(b)) return foodDb.bucketBegin(b) + 1;
+  for (int nb = b - 1; nb >= 0; nb--) {
+    if (foodDb.bucketBegin(nb) < foodDb.bucketBegin(nb + 1)) return foodDb.bucketBegin(nb) + 1;
+  }
   return 0;
 }
 
-void updateTopBarHUD() {
-  // čas + datum
-  String timeStr = getTimeString();
-  String dateStr = getDateString();
+void drawMenu2Screen() {
+  tft.fillScreen(COLOR_BG);
 
-  if (timeStr != lastTimeStr || dateStr != lastDateStr) {
-    // smažeme střed top baru (pod textem) – necháme gradient pod tím
-    tft.fillRect(110, 4, 130, 18, COLOR_BG);  // malý "průhled" – přes něj text
-    tft.setTextSize(1);
-    tft.setTextColor(COLOR_TEXT);
-    tft.setCursor(115, 6);
-    tft.print(timeStr);
-    tft.setCursor(115, 14);
-    tft.print(dateStr);
+  // top bar ve zluté
+  tft.fillRect(0, 0, 320, 24, COLOR_MENU2_ACCENT);
+  tft.setTextColor(COLOR_BG);
+  tft.setTextSize(1);
+  tft.setCursor(4, 6);
+  tft.print("Potraviny");
 
-    lastTimeStr = timeStr;
-    lastDateStr = dateStr;
-  }
+  listInvalidate(foodMenu);
+  drawListHint("Otacej, rychle = po pismenech, stisk = vybrat");
+}
 
-  // WiFi síla
-  int rssi = 0;
-  int level = 0;
-  if (WiFi.status() == WL_CONNECTED) {
-    rssi = WiFi.RSSI();
-    level = wifiLevelFromRSSI(rssi);
+// ---- MENU_COUNT (zelené) – počítání kusů ----
+
+int countMenuCount() {
+  return COUNT_REF_OPTIONS + 2;
+}
+
+void countMenuLabel(int index, char* buf, size_t len) {
+  if (index == 0) {
+    strlcpy(buf, "Zpet", len);
+  } else if (index <= COUNT_REF_OPTIONS) {
+    snprintf(buf, len, "Vzorek %d ks", COUNT_REF_PIECES[index - 1]);
   } else {
-    level = 0;
+    strlcpy(buf, "Ukoncit pocitani", len);
   }
+}
 
-  if (level != lastWifiLevel) {
-    drawWifiIcon(level);
-    lastWifiLevel = level;
-  }
+bool countMenuMarked(int index) {
+  return countMode && index >= 1 && index <= COUNT_REF_OPTIONS &&
+         pieceCounter.getState() != PC_COUNTING &&
+         COUNT_REF_PIECES[index - 1] == pieceCounter.getRefPieces();
 }
 
-void updateWeightHUD() {
-  // jen když se změnila (trochu)
-  if (fabs(currentWeight - lastDrawnWeight) < 0.05f) {
-    return;
-  }
+void drawCountMenuScreen() {
+  tft.fillScreen(COLOR_BG);
 
+  tft.fillRect(0, 0, 320, 24, COLOR_ACCENT);
+  tft.setTextColor(COLOR_BG);
+  tft.setTextSize(1);
+  tft.setCursor(4, 6);
+  tft.print("Pocitani kusu");
+
+  listInvalidate(countMenu);
+  drawListHint("Vyber velikost vzorku, prazdna vaha = nula");
+}
+
+// ========================
+// TAR – zobrazení
+// ========================
+void drawTarMessage() {
   eraseWeightArea();
 
-  // velké číslo – tady by šel použít Orbitron jako vlastní font,
-  // pro teď použijeme default s větším textSize
-  tft.setTextColor(COLOR_TEXT);
   tft.setTextSize(4);
+  tft.setTextColor(COLOR_ACCENT);
 
-  char buf[16];
-  dtostrf(currentWeight, 0, 1, buf);
-
-  // spočítáme šířku textu nahrubo (4 px * size + mezery)
-  int len = strlen(buf);
-  int charW = 6 * 4; // 6px * size4
+  const char* txt = "TAR";
+  int len = strlen(txt);
+  int charW = 6 * 4; // 6 px * size4
   int totalW = len * charW;
 
   int boxX = 20;
@@ -614,266 +3814,1170 @@ void updateWeightHUD() {
   int x = boxX + (boxW - totalW) / 2;
   int y = 90;
 
-  // "glow" – nejdřív tmavší stín
-  tft.setTextColor(COLOR_TOPBAR2);
-  tft.setCursor(x + 2, y + 2);
-  tft.print(buf);
-
-  // pak ostrý text
-  tft.setTextColor(COLOR_TEXT);
   tft.setCursor(x, y);
-  tft.print(buf);
+  tft.print(txt);
+}
+
+// ========================
+// HUD – plánování snímků
+// ========================
+// Každý widget si hlídá, co naposledy nakreslil, a kreslí jen při změně.
+// Plánovač k tomu volí kadenci: když se hýbe váha nebo enkodér, snímek
+// každých ~30 ms; v klidu jen 4× za sekundu kontrola (kreslí se pak
+// prakticky jen hodiny jednou za sekundu). Změna se pozná levným
+// porovnáním v každém průchodu loopu, takže přechod z klidu je okamžitý.
+const unsigned long HUD_ACTIVE_FRAME_MS = 30;     // ~33 fps
+const unsigned long HUD_IDLE_FRAME_MS   = 250;
+const unsigned long HUD_ACTIVE_HOLD_MS  = 1500;   // jak dlouho po poslední změně zůstat rychlý
+
+struct HudStats {
+  uint32_t frames;         // vykreslené snímky (něco se kreslilo)
+  uint32_t skipped;        // naplánované snímky, kdy nebylo co kreslit
+  uint32_t late;           // snímek začal o víc než jeden interval pozdě
+  float    fps;            // za poslední sekundu
+  float    skippedPerSec;
+  uint32_t frameUsAvg;     // délka vykresleného snímku, poslední sekunda
+  uint32_t frameUsMax;
+};
+
+HudStats hudStats = {};
+unsigned long hudLastFrameMs   = 0;
+unsigned long hudActiveUntilMs = 0;
+bool          hudForceFrame    = true;
 
-  lastDrawnWeight = currentWeight;
+// okno pro fps
+unsigned long hudWindowStartMs = 0;
+uint32_t hudWindowFrames  = 0;
+uint32_t hudWindowSkipped = 0;
+uint64_t hudWindowUs      = 0;
+uint32_t hudWindowMaxUs   = 0;
+
+bool hudActive() {
+  return (long)(hudActiveUntilMs - millis()) > 0;
 }
 
-void updateBottomHUD() {
-  // encoder info dole
-  tft.fillRect(0, 222, 320, 18, COLOR_BG);
-  tft.setTextSize(1);
-  tft.setTextColor(COLOR_TEXT);
-  tft.setCursor(4, 224);
-  tft.print("ENC: ");
-  tft.print(encoderPosition);
+// levná kontrola v každém průchodu loopu
+void hudCheckActivity() {
+  bool busy;
+  if (checkMode) {
+    // verdikt má jít na displej hned, ne až v dalším klidovém tiku
+    busy = checkWeigher.getStats().total != lastDrawnCheckTotal ||
+           (int)checkWeigher.getState() != lastDrawnCheckState;
+  } else {
+    busy = encoder.position() != lastDrawnEnc ||
+           (button.pressed() ? 1 : 0) != lastDrawnBtn ||
+           wpRoundMg(hudWeightMg(), WEIGHT_DECIMALS) != lastDrawnWeightMg;
+  }
+  if (!busy) return;
 
-  tft.setCursor(120, 224);
-  tft.print("BTN: ");
-  tft.print(lastButtonState == LOW ? "PRESS" : "----");
+  if (!hudActive()) hudForceFrame = true;   // z klidu nečekat na další tik
+  hudActiveUntilMs = millis() + HUD_ACTIVE_HOLD_MS;
+}
+
+bool hudFrameDue() {
+  if (hudForceFrame) return true;
+  unsigned long interval = hudActive() ? HUD_ACTIVE_FRAME_MS : HUD_IDLE_FRAME_MS;
+  return millis() - hudLastFrameMs >= interval;
+}
+
+// frameUs = 0 -> nic se nekreslilo
+void hudNoteFrame(unsigned long startMs, uint32_t frameUs) {
+  unsigned long interval = hudActive() ? HUD_ACTIVE_FRAME_MS : HUD_IDLE_FRAME_MS;
+  if (!hudForceFrame && hudLastFrameMs && startMs - hudLastFrameMs >= 2 * interval) {
+    hudStats.late++;
+  }
+  hudLastFrameMs = startMs;
+  hudForceFrame  = false;
+
+  if (frameUs) {
+    hudStats.frames++;
+    hudWindowFrames++;
+    hudWindowUs += frameUs;
+    if (frameUs > hudWindowMaxUs) hudWindowMaxUs = frameUs;
+  } else {
+    hudStats.skipped++;
+    hudWindowSkipped++;
+  }
+
+  unsigned long span = startMs - hudWindowStartMs;
+  if (span >= 1000) {
+    hudStats.fps           = hudWindowFrames * 1000.0f / span;
+    hudStats.skippedPerSec = hudWindowSkipped * 1000.0f / span;
+    hudStats.frameUsAvg    = hudWindowFrames ? (uint32_t)(hudWindowUs / hudWindowFrames) : 0;
+    hudStats.frameUsMax    = hudWindowMaxUs;
+    hudWindowStartMs = startMs;
+    hudWindowFrames  = 0;
+    hudWindowSkipped = 0;
+    hudWindowUs      = 0;
+    hudWindowMaxUs   = 0;
+  }
 }
 
-// vykreslí jednu položku menu (jen daný řádek)
-void drawMenuItem(int index, bool selected) {
-  int startY = 40;
-  int lineH  = 24;
-  int y = startY + index * lineH;
+// jeden snímek HUD; vrací true, když se něco kreslilo
+bool renderHudFrame() {
+  WdStage st(WD_LOOP, ST_HUD);
+  bool drawn = false;
+
+  // pokud je aktivní TAR, zobraz hlášku 3s místo váhy
+  if (tarActive) {
+    drawn |= updateTopBarHUD();
+    drawn |= updateBottomHUD();
+
+    if (!tarDrawn) {
+      drawTarMessage();
+      tarDrawn = true;
+      drawn = true;
+    }
+
+    if (millis() - tarStartMs >= 3000) {
+      tarActive = false;
+      tarDrawn  = false;
+      lastDrawnWeightMg = WEIGHT_NONE; // vynutíme překreslení váhy
+      for (int z = 0; z < ZONE_COUNT; z++) lastDrawnZoneMg[z] = WEIGHT_NONE;
+      hudGesture.reset(encoder.position(), millis());   // otáčení v HUD od nuly
+      hudForceFrame        = true;
+    }
+  } else if (checkMode) {
+    drawn |= updateTopBarHUD();
+    drawn |= updateCheckHUD();
+  } else {
+    drawn |= updateTopBarHUD();
+    if (recipeMode) {
+      drawn |= updateRecipeHUD();    // celý rámeček včetně stavového řádku
+    } else if (countMode) {
+      drawn |= updateCountHUD();     // stavový řádek v rámečku kreslí samo
+    } else {
+      drawn |= updateWeightHUD();
+      drawn |= updateDynamicHUD();
+    }
+    drawn |= updateTareHUD();
+    if (!recipeMode) drawn |= updateZonesHUD();
+    drawn |= updateTrendHUD();
+    drawn |= updateBottomHUD();
+  }
+  return drawn;
+}
+
+String hudJson() {
+  String json = "\"hud\":{";
+  json += "\"mode\":\"" + String(hudActive() ? "active" : "idle") + "\"";
+  json += ",\"fps\":" + String(hudStats.fps, 1);
+  json += ",\"skipped_per_s\":" + String(hudStats.skippedPerSec, 1);
+  json += ",\"frames\":" + String(hudStats.frames);
+  json += ",\"skipped\":" + String(hudStats.skipped);
+  json += ",\"late\":" + String(hudStats.late);
+  json += ",\"frame_us_avg\":" + String(hudStats.frameUsAvg);
+  json += ",\"frame_us_max\":" + String(hudStats.frameUsMax);
+  json += "}";
+  return json;
+}
+
+// ========================
+// Cache odpovědí a limit dotazů
+// ========================
+// WebServer obsluhuje jednoho klienta naráz – dashboard, který se ptá
+// 50× za sekundu, nebo deset otevřených záložek by jinak zahltily loop.
+// Pollované odpovědi (/api/state, /api_json) se proto skládají jen při
+// změně stateVersion nebo tiku hodin, jinak se pošlou hotové bajty.
+// ETag = verze: prohlížeč s If-None-Match dostane prázdné 304.
+// Každá IP má token bucket; po vyčerpání 429 s Retry-After.
+const float RATE_PER_SEC = 10.0f;     // trvalá rychlost na klienta
+const float RATE_BURST   = 20.0f;     // krátkodobá špička
+const int   RATE_CLIENTS = 8;         // sledovaných IP (nejdéle neaktivní se přepíše)
+
+struct CachedResponse {
+  bool     valid;
+  uint32_t version;
+  uint32_t clock;
+  String   body;
+};
+
+struct RateBucket {
+  uint32_t ip;
+  float    tokens;
+  unsigned long lastMs;
+};
+
+CachedResponse stateCache   = {};
+CachedResponse apiJsonCache = {};
+CachedResponse summaryCache = {};
+RateBucket     rateBuckets[RATE_CLIENTS] = {};
+
+uint32_t httpCacheHits    = 0;
+uint32_t httpCacheBuilds  = 0;
+uint32_t httpNotModified  = 0;
+uint32_t httpRateLimited  = 0;
+
+// false = odpověď 429 už odešla
+bool rateLimitOk() {
+  uint32_t ip = (uint32_t)server.client().remoteIP();
+  unsigned long now = millis();
+
+  RateBucket* b = nullptr;
+  RateBucket* oldest = &rateBuckets[0];
+  for (int i = 0; i < RATE_CLIENTS; i++) {
+    if (rateBuckets[i].ip == ip && rateBuckets[i].lastMs) {
+      b = &rateBuckets[i];
+      break;
+    }
+    if (rateBuckets[i].lastMs < oldest->lastMs) oldest = &rateBuckets[i];
+  }
+  if (!b) {
+    b = oldest;
+    b->ip     = ip;
+    b->tokens = RATE_BURST;
+    b->lastMs = now;
+  }
+
+  b->tokens += (now - b->lastMs) * (RATE_PER_SEC / 1000.0f);
+  if (b->tokens > RATE_BURST) b->tokens = RATE_BURST;
+  b->lastMs = now ? now : 1;
+
+  if (b->tokens < 1.0f) {
+    httpRateLimited++;
+    server.sendHeader("Retry-After", "1");
+    server.send(429, "text/plain", "Too Many Requests");
+    return false;
+  }
+  b->tokens -= 1.0f;
+  return true;
+}
+
+// pošle JSON z cache, build() jen když se od minula změnil stav nebo čas
+void sendCachedJson(CachedResponse& c, String (*build)()) {
+  uint32_t ver = stateVersion;
+  uint32_t clk = clockVersion;
+  char etag[20];
+  snprintf(etag, sizeof(etag), "\"%08x%08x\"", (unsigned)ver, (unsigned)clk);
+
+  server.sendHeader("ETag", etag);
+  server.sendHeader("Cache-Control", "no-cache");
+  if (server.header("If-None-Match") == etag) {
+    httpNotModified++;
+    server.send(304);
+    return;
+  }
+
+  if (!c.valid || c.version != ver || c.clock != clk) {
+    c.body    = build();
+    c.version = ver;
+    c.clock   = clk;
+    c.valid   = true;
+    httpCacheBuilds++;
+  } else {
+    httpCacheHits++;
+  }
+  server.send(200, "application/json", c.body);
+}
+
+// ========================
+// HTTP handlery
+// ========================
+void handleRoot() {
+  server.send_P(200, "text/html; charset=utf-8", INDEX_HTML);
+}
+
+// "cells":[...],"zones":[...] – jednotlivé kanály do JSONu
+String loadCellsJson() {
+  String json = "\"cells\":[";
+  for (int i = 0; i < LOAD_CELL_COUNT; i++) {
+    if (i > 0) json += ",";
+    json += weightText(weighing.cellMg[i]);
+  }
+  json += "],\"zones\":[";
+  for (int z = 0; z < ZONE_COUNT; z++) {
+    if (z > 0) json += ",";
+    json += weightText(weighing.zoneMg[z]);
+  }
+  json += "]";
+  return json;
+}
+
+// "tare":{...} – aktivní nádoba
+String tareJson() {
+  String json = "\"tare\":{\"container\":";
+  if (activeContainer >= 0) {
+    json += "\"" + String(containers[activeContainer].name) + "\"";
+  } else {
+    json += "null";
+  }
+  json += ",\"grams\":" + weightText(weighing.containerTareMg) + "}";
+  return json;
+}
+
+// "food":{...} – vybraná potravina a výživa pro aktuální hmotnost
+String foodJson() {
+  if (!currentFood) return "\"food\":null";
+
+  Nutrition n = nutritionFor(currentFood, displayWeightMg());
+  String json = "\"food\":{\"id\":" + String(currentFood->id);
+  json += ",\"name\":\"" + jsonText(foodDb.name(currentFood)) + "\"";
+  json += ",\"kcal\":" + String(n.kcal, 1);
+  json += ",\"protein\":" + String(n.protein, 1);
+  json += ",\"carbs\":" + String(n.carbs, 1);
+  json += ",\"fat\":" + String(n.fat, 1) + "}";
+  return json;
+}
+
+// "dynamic":{...} – stav dynamického vážení
+String dynamicJson() {
+  String json = "\"dynamic\":{\"active\":";
+  json += dynamicMode ? "true" : "false";
+  json += ",\"state\":\"";
+  json += dynamicMode ? dynamicStateName() : "off";
+  json += "\",\"value\":" + weightText(displayWeightMg());
+  json += ",\"confidence\":" + String(dynamicMode ? dynWeigher.confidence() : 0.0f, 2);
+  json += "}";
+  return json;
+}
+
+// "check":{...} – kontrolní vážení, poslední verdikt a počty
+String checkJson() {
+  const CheckWeighStats& st = checkWeigher.getStats();
+  String json = "\"check\":{\"active\":";
+  json += checkMode ? "true" : "false";
+  json += ",\"state\":\"" + String(checkStateName()) + "\"";
+  json += ",\"verdict\":\"" + String(checkVerdictName(checkWeigher.getVerdict())) + "\"";
+  json += ",\"last\":" + weightText(checkWeigher.getLastMg());
+  json += ",\"total\":" + String(st.total);
+  json += ",\"pass\":" + String(st.pass);
+  json += ",\"under\":" + String(st.under);
+  json += ",\"over\":" + String(st.over);
+  json += ",\"unsettled\":" + String(st.unsettled);
+  json += "}";
+  return json;
+}
+
+// "recipe":{...} – aktuální krok receptu
+String recipeJson() {
+  String json = "\"recipe\":{\"active\":";
+  json += recipeMode ? "true" : "false";
+  if (recipeMode) {
+    json += ",\"finished\":" + String(recipe.finished() ? "true" : "false");
+    json += ",\"step\":" + String(recipe.currentStep() + 1);
+    json += ",\"steps\":" + String(recipe.stepCount());
+    if (recipe.running()) {
+      const RecipeStep& st = recipe.step(recipe.currentStep());
+      json += ",\"name\":\"" + String(st.name) + "\"";
+      json += ",\"target\":" + weightText(st.targetMg);
+      json += ",\"current\":" + weightText(recipe.stepMg());
+    }
+  }
+  json += "}";
+  return json;
+}
+
+// "count":{...} – počítání kusů
+String countJson() {
+  String json = "\"count\":{\"active\":";
+  json += countMode ? "true" : "false";
+  if (countMode) {
+    int pieces = currentPieceCount();
+    char unit[16];
+    wpFormatMg((int32_t)pieceCounter.getUnitUg(), 3, unit);   // µg -> "mg.µg"
+    json += ",\"state\":\"" + String(countStateName()) + "\"";
+    json += ",\"pieces\":" + String(pieces);
+    json += ",\"reliable\":" + String(pieceCounter.getState() == PC_COUNTING && pieceCounter.reliable(pieces) ? "true" : "false");
+    json += ",\"unit_mg\":" + String(unit);
+    json += ",\"ref_pieces\":" + String(pieceCounter.getRefPieces());
+    json += ",\"max_reliable\":" + String(pieceCounter.maxReliable());
+    json += ",\"refines\":" + String(pieceCounter.getRefines());
+  }
+  json += "}";
+  return json;
+}
+
+String clockJson() {
+  String json = "\"clock\":{";
+  json += "\"synced\":" + String(clockSynced ? "true" : "false");
+  json += ",\"epoch\":" + String(clockEpoch());
+  json += ",\"utc_offset_s\":" + String(clockUtcOffset);
+  json += ",\"last_sync\":" + String((uint32_t)clockLastSync);
+  json += ",\"syncs\":" + String(clockSyncCount);
+  json += ",\"correction_ms\":" + String(clockCorrectionMs);
+  json += "}";
+  return json;
+}
+
+// /api/state – váha se čte v loopu, tady se jen skládá odpověď
+String buildStateJson() {
+  int rssi = (WiFi.status() == WL_CONNECTED) ? WiFi.RSSI() : 0;
+
+  String json = "{";
+  json += "\"weight\":" + weightText(currentWeightMg) + ",";
+  json += "\"stable\":" + String(weighing.stable ? "true" : "false") + ",";
+  json += "\"item\":\"" + jsonText(currentItem) + "\",";
+  json += "\"rssi\":" + String(rssi) + ",";
+  json += clockJson() + ",";
+  json += hudJson() + ",";
+  json += loadCellsJson() + ",";
+  json += tareJson() + ",";
+  json += foodJson() + ",";
+  json += dynamicJson() + ",";
+  json += countJson() + ",";
+  json += recipeJson() + ",";
+  json += checkJson();
+  json += "}";
+  return json;
+}
+
+void handleState() {
+  if (!rateLimitOk()) return;
+  sendCachedJson(stateCache, buildStateJson);
+}
+
+// /api/summary – to málo, co o sobě váha říká ostatním (flotila)
+String buildSummaryJson() {
+  const char* mode = checkMode ? "check" : recipeMode ? "recipe" :
+                     countMode ? "count" : dynamicMode ? "dynamic" : "weigh";
+  String json = "{";
+  json += "\"id\":\"" + String(deviceId) + "\",";
+  json += "\"host\":\"" + String(deviceId) + ".local\",";
+  json += "\"weight\":" + weightText(currentWeightMg) + ",";
+  json += "\"stable\":" + String(weighing.stable ? "true" : "false") + ",";
+  json += "\"item\":\"" + jsonText(currentItem) + "\",";
+  json += "\"mode\":\"" + String(mode) + "\"";
+  json += "}";
+  return json;
+}
+
+void handleSummary() {
+  if (!rateLimitOk()) return;
+  sendCachedJson(summaryCache, buildSummaryJson);
+}
+
+// /api/fleet – tahle váha + poslední známý stav ostatních
+void handleFleet() {
+  if (!rateLimitOk()) return;
+  if (!fleetLock) {
+    server.send(503, "text/plain", "mDNS not running");
+    return;
+  }
+  uint32_t now = millis();
+  bool idle = !fleetWantedMs || now - fleetWantedMs > FLEET_IDLE_MS;
+  fleetWantedMs = now ? now : 1;
+  if (idle && fleetTaskHandle) xTaskNotifyGive(fleetTaskHandle);   // sken hned
+
+  String json = "{\"self\":" + buildSummaryJson();
+  xSemaphoreTake(fleetLock, portMAX_DELAY);
+  json += ",\"scans\":" + String(fleetScans);
+  json += ",\"scan_ms\":" + String(fleetScanDurMs);
+  json += ",\"scan_age_ms\":" + String(fleetScans ? now - fleetScanMs : 0);
+  json += ",\"peers\":[";
+  for (int i = 0; i < fleetPeerCount; i++) {
+    const FleetPeer& p = fleetPeers[i];
+    // id a host jsou z mDNS, item a mode z odpovědi – vše cizí text
+    String id   = jsonText(p.id);
+    String host = jsonText(p.host);
+    if (i > 0) json += ",";
+    json += "{\"id\":\"" + id + "\"";
+    json += ",\"host\":\"" + host + "\"";
+    json += ",\"ip\":\"" + p.ip.toString() + "\"";
+    json += ",\"ok\":" + String(p.ok ? "true" : "false");
+    json += ",\"age_ms\":" + String(p.okMs ? now - p.okMs : 0);
+    json += ",\"latency_ms\":" + String(p.latencyMs);
+    if (p.okMs) {
+      json += ",\"summary\":{\"id\":\"" + id + "\"";
+      json += ",\"host\":\"" + host + "\"";
+      json += ",\"weight\":" + weightText(p.weightMg);
+      json += ",\"stable\":" + String(p.stable ? "true" : "false");
+      json += ",\"item\":\"" + jsonText(p.item) + "\"";
+      json += ",\"mode\":\"" + jsonText(p.mode) + "\"}";
+    } else {
+      json += ",\"summary\":null";
+    }
+    json += "}";
+  }
+  xSemaphoreGive(fleetLock);
+  json += "]}";
+
+  server.sendHeader("Cache-Control", "no-store");
+  server.send(200, "application/json", json);
+}
+
+void handleFleetPage() {
+  server.send_P(200, "text/html; charset=utf-8", FLEET_HTML);
+}
+
+void handleItemPost() {
+  if (server.hasArg("item")) {
+    currentItem = server.arg("item");
+    currentFood = nullptr;
+    mqttSetItem(currentItem);
+    lastDrawnWeightMg = WEIGHT_NONE;
+    stateVersion++;
+    Serial.print("New item: ");
+    Serial.println(currentItem);
+    setDynamicMode(currentItem == "Zvíře");
+    server.send(200, "text/plain", "OK");
+  } else {
+    server.send(400, "text/plain", "Missing 'item'");
+  }
+}
+
+// /api_json – tvoje API
+String buildApiJson() {
+  String json = "{";
+  json += "\"weight\":" + weightText(currentWeightMg) + ",";
+  json += "\"item\":\"" + jsonText(currentItem) + "\",";
+  ClockText ct;
+  clockRead(ct);
+  json += "\"date\":\"" + String(ct.date) + "\",";
+  json += "\"time\":\"" + String(ct.time) + "\",";
+  json += clockJson() + ",";
+  json += loadCellsJson() + ",";
+  json += tareJson() + ",";
+  json += foodJson() + ",";
+  json += dynamicJson() + ",";
+  json += countJson() + ",";
+  json += recipeJson();
+  json += "}";
+  return json;
+}
+
+void handleApiJson() {
+  if (!rateLimitOk()) return;
+  sendCachedJson(apiJsonCache, buildApiJson);
+}
+
+// /api/cells – detail kanálů (surová data, tara, kalibrace); hodnoty
+// z posledního čtení v loopu, HX711 se kvůli dotazu nečte
+void handleCellsGet() {
+  if (!rateLimitOk()) return;
+
+  String json = "{\"total\":" + weightText(currentWeightMg) + ",\"cells\":[";
+  for (int i = 0; i < LOAD_CELL_COUNT; i++) {
+    if (i > 0) json += ",";
+    json += "{\"raw\":" + String(cellRaw[i]);
+    json += ",\"offset\":" + String(weighing.cellOffset[i]);
+    json += ",\"scale\":" + String(weighing.cellScale[i], 4);
+    json += ",\"zone\":" + String(LOAD_CELLS[i].zone);
+    json += ",\"weight\":" + weightText(weighing.cellMg[i]) + "}";
+  }
+  json += "],\"zones\":[";
+  for (int z = 0; z < ZONE_COUNT; z++) {
+    if (z > 0) json += ",";
+    json += weightText(weighing.zoneMg[z]);
+  }
+  json += "]}";
+  server.send(200, "application/json", json);
+}
+
+// /api/cells/calibrate – cell=N a buď grams=známé závaží na článku, nebo scale=přímo
+void handleCellsCalibrate() {
+  if (!server.hasArg("cell")) {
+    server.send(400, "text/plain", "Missing 'cell'");
+    return;
+  }
+  int cell = server.arg("cell").toInt();
+  if (cell < 0 || cell >= LOAD_CELL_COUNT) {
+    server.send(400, "text/plain", "Bad 'cell'");
+    return;
+  }
 
-  if (selected) {
-    // highlight + glow
-    tft.fillRoundRect(10, y - 2, 300, lineH, 8, COLOR_TOPBAR2);
-    tft.setTextColor(COLOR_BG);
+  if (server.hasArg("scale")) {
+    float sc = server.arg("scale").toFloat();
+    if (sc == 0.0f) {
+      server.send(400, "text/plain", "Bad 'scale'");
+      return;
+    }
+    weighing.setCellScale(cell, sc);
+  } else if (server.hasArg("grams")) {
+    float grams = server.arg("grams").toFloat();
+    long delta  = cellRaw[cell] - weighing.cellOffset[cell];
+    if (grams <= 0.0f || delta == 0) {
+      server.send(400, "text/plain", "Bad 'grams' or empty cell");
+      return;
+    }
+    weighing.setCellScale(cell, delta / grams);
   } else {
-    tft.fillRoundRect(10, y - 2, 300, lineH, 8, COLOR_BG);
-    tft.drawRoundRect(10, y - 2, 300, lineH, 8, COLOR_TOPBAR2);
-    tft.setTextColor(COLOR_TEXT);
+    server.send(400, "text/plain", "Missing 'grams' or 'scale'");
+    return;
   }
 
-  tft.setTextSize(2);
-  tft.setCursor(20, y + 2);
-  tft.print(MENU_LABELS[index]);
+  saveCellCalibration(cell);
+  Serial.printf("[CAL] cell %d scale=%.4f\n", cell, weighing.cellScale[cell]);
+  server.send(200, "text/plain", "OK");
 }
 
+// /api/trace/start – dest=serial|file, seconds=N (0 = do stopu; soubor nejvýš do rozpočtu)
+void handleTraceStart() {
+  String dest = server.hasArg("dest") ? server.arg("dest") : String("file");
+  long seconds = server.hasArg("seconds") ? server.arg("seconds").toInt() : 10;
+  if (seconds < 0) {
+    server.send(400, "text/plain", "Bad 'seconds'");
+    return;
+  }
 
-// ========================
-// MENU – kreslení
-// ========================
-void drawMenuScreen() {
-  tft.fillScreen(COLOR_BG);
-
-  // top bar znovu použijeme jako header menu
-  drawTopBarGradient();
-  tft.setTextColor(COLOR_TEXT);
-  tft.setTextSize(1);
-  tft.setCursor(4, 6);
-  tft.print("Menu");
-
-  // položky menu
-  for (int i = 0; i < MENU_ITEMS; i++) {
-    drawMenuItem(i, i == menuIndex);
+  TraceDest d;
+  if (dest == "serial")    d = TRACE_SERIAL;
+  else if (dest == "file") d = TRACE_FILE;
+  else {
+    server.send(400, "text/plain", "Bad 'dest'");
+    return;
   }
 
-  tft.setTextSize(1);
-  tft.setTextColor(COLOR_TEXT);
-  tft.setCursor(4, 224);
-  tft.print("Otacej pro vyber, stisk pro potvrzeni");
+  if (!traceStart(d, (uint32_t)seconds)) {
+    server.send(409, "text/plain", "Trace already running or no space");
+    return;
+  }
+  server.send(200, "text/plain", "OK");
 }
 
-void updateMenuSelectionFromEncoder() {
-  long diff = encoderPosition - menuEncStart;
-  int newIndex = (int)diff;
+void handleTraceStop() {
+  traceStop();
+  server.send(200, "text/plain", "OK");
+}
 
-  if (newIndex < 0) newIndex = 0;
-  if (newIndex >= MENU_ITEMS) newIndex = MENU_ITEMS - 1;
+// /api/trace – stažení posledního záznamu ze souboru
+void handleTraceDownload() {
+  if (traceDest == TRACE_FILE) {
+    server.send(409, "text/plain", "Trace still running");
+    return;
+  }
+  File f = LittleFS.open(TRACE_FILE_PATH, "r");
+  if (!f) {
+    server.send(404, "text/plain", "No trace");
+    return;
+  }
+  server.sendHeader("Content-Disposition", "attachment; filename=trace.csv");
+  server.streamFile(f, "text/csv");
+  f.close();
+}
 
-  if (newIndex != menuIndex) {
-    // přepni jen řádky, ne celé menu
-    drawMenuItem(menuIndex, false);
-    drawMenuItem(newIndex, true);
-    menuIndex = newIndex;
+// /api/containers – tabulka nádob
+void handleContainersGet() {
+  String json = "{\"active\":" + String(activeContainer) + ",\"containers\":[";
+  for (int i = 0; i < containerCount; i++) {
+    if (i > 0) json += ",";
+    json += "{\"id\":" + String(i);
+    json += ",\"name\":\"" + String(containers[i].name) + "\"";
+    json += ",\"grams\":" + weightText(wpGramsToMg(containers[i].grams)) + "}";
   }
+  json += "]}";
+  server.send(200, "application/json", json);
 }
 
-// ---- TARE menu (červené) ----
+// POST /api/containers – id=N (jinak nová), name=..., grams=... nebo learn=1
+// (learn vezme aktuální ustálenou hmotnost na váze)
+void handleContainersPost() {
+  int idx = server.hasArg("id") ? server.arg("id").toInt() : -1;
+  if (idx >= containerCount) {
+    server.send(400, "text/plain", "Bad 'id'");
+    return;
+  }
 
-void drawTareMenuItem(int index, bool selected) {
-  int startY = 40;
-  int lineH  = 24;
-  int y = startY + index * lineH;
+  float grams;
+  if (server.hasArg("learn")) {
+    if (!weighing.stable) {
+      server.send(409, "text/plain", "Scale not stable");
+      return;
+    }
+    grams = weighing.grossMg / 1000.0f;
+  } else if (server.hasArg("grams")) {
+    grams = server.arg("grams").toFloat();
+  } else if (idx >= 0) {
+    grams = containers[idx].grams;
+  } else {
+    server.send(400, "text/plain", "Missing 'grams' or 'learn'");
+    return;
+  }
 
-  if (selected) {
-    tft.fillRoundRect(10, y - 2, 300, lineH, 8, COLOR_MENU_TARE_ACCENT);
-    tft.setTextColor(COLOR_BG);
+  if (idx < 0) {
+    if (!server.hasArg("name")) {
+      server.send(400, "text/plain", "Missing 'name'");
+      return;
+    }
+    idx = addContainer(server.arg("name"), grams);
+    if (idx < 0) {
+      server.send(507, "text/plain", "Container table full");
+      return;
+    }
   } else {
-    tft.fillRoundRect(10, y - 2, 300, lineH, 8, COLOR_BG);
-    tft.drawRoundRect(10, y - 2, 300, lineH, 8, COLOR_MENU_TARE_ACCENT);
-    tft.setTextColor(COLOR_TEXT);
+    if (server.hasArg("name")) setContainerName(idx, server.arg("name"));
+    containers[idx].grams = grams;
+    saveContainers();
+    if (idx == activeContainer) applyContainer(idx);
   }
 
-  tft.setTextSize(2);
-  tft.setCursor(20, y + 2);
-  tft.print(MENU_TARE_LABELS[index]);
+  if (uiMode == UI_MENU_TARE) drawTareMenuRows();
+  server.send(200, "application/json", "{\"id\":" + String(idx) + "}");
 }
 
-void drawTareMenuScreen() {
-  tft.fillScreen(COLOR_BG);
-
-  // top bar v červené
-  tft.fillRect(0, 0, 320, 24, COLOR_MENU_TARE_ACCENT);
-  tft.setTextColor(COLOR_BG);
-  tft.setTextSize(1);
-  tft.setCursor(4, 6);
-  tft.print("Nadoba / miska");
-
-  for (int i = 0; i < MENU_TARE_ITEMS; i++) {
-    drawTareMenuItem(i, i == menuTareIndex);
+void handleContainersDelete() {
+  if (!server.hasArg("id") || !deleteContainer(server.arg("id").toInt())) {
+    server.send(400, "text/plain", "Bad 'id'");
+    return;
+  }
+  if (uiMode == UI_MENU_TARE) {
+    listScrollTo(tareMenu, 0);
+    drawTareMenuRows();
   }
+  server.send(200, "text/plain", "OK");
+}
 
-  tft.setTextSize(1);
-  tft.setTextColor(COLOR_TEXT);
-  tft.setCursor(4, 224);
-  tft.print("Otacej, stisk pro potvrzeni");
+// POST /api/containers/apply – id=N, -1 = bez nádoby
+void handleContainersApply() {
+  int idx = server.hasArg("id") ? server.arg("id").toInt() : -1;
+  if (idx >= containerCount) {
+    server.send(400, "text/plain", "Bad 'id'");
+    return;
+  }
+  applyContainer(idx);
+  server.send(200, "text/plain", "OK");
 }
 
-void updateTareMenuSelectionFromEncoder() {
-  long diff = encoderPosition - menuEncStart;
-  int newIndex = (int)diff;
+// /api/foods?q=prefix&limit=N – hledání podle začátku jména
+void handleFoodsSearch() {
+  String q = server.hasArg("q") ? server.arg("q") : String("");
+  int limit = server.hasArg("limit") ? server.arg("limit").toInt() : 20;
+  if (limit < 1) limit = 1;
+  if (limit > 50) limit = 50;
+
+  const FoodRecord* found[50];
+  int n = foodDb.searchPrefix(q.c_str(), found, limit);
+
+  String json = "{\"total\":" + String(foodDb.count()) + ",\"results\":[";
+  for (int i = 0; i < n; i++) {
+    if (i > 0) json += ",";
+    json += "{\"id\":" + String(found[i]->id);
+    json += ",\"name\":\"" + jsonText(foodDb.name(found[i])) + "\"";
+    json += ",\"kcal100\":" + String(found[i]->kcal / 10.0f, 1) + "}";
+  }
+  json += "]}";
+  server.send(200, "application/json", json);
+}
 
-  if (newIndex < 0) newIndex = 0;
-  if (newIndex >= MENU_TARE_ITEMS) newIndex = MENU_TARE_ITEMS - 1;
+// POST /api/food – id=N vybere potravinu, id=-1 zruší
+void handleFoodSelect() {
+  if (!server.hasArg("id")) {
+    server.send(400, "text/plain", "Missing 'id'");
+    return;
+  }
+  long id = server.arg("id").toInt();
+  if (id < 0) {
+    selectFood(nullptr);
+    server.send(200, "text/plain", "OK");
+    return;
+  }
 
-  if (newIndex != menuTareIndex) {
-    drawTareMenuItem(menuTareIndex, false);
-    drawTareMenuItem(newIndex, true);
-    menuTareIndex = newIndex;
+  const FoodRecord* f = foodDb.findById((uint32_t)id);
+  if (!f) {
+    server.send(404, "text/plain", "Unknown food");
+    return;
   }
+  selectFood(f);
+  server.send(200, "text/plain", "OK");
 }
 
-// ---- MENU2 (žluté) ----
-
-void drawMenu2Item(int index, bool selected) {
-  int startY = 40;
-  int lineH  = 24;
-  int y = startY + index * lineH;
+// /api/mqtt – konfigurace a stav MQTT
+void handleMqttGet() {
+  portENTER_CRITICAL(&mqttMux);
+  MqttConfig c = mqttCfg;
+  portEXIT_CRITICAL(&mqttMux);
+  String json = "{\"enabled\":" + String(c.enabled ? "true" : "false");
+  json += ",\"host\":\"" + jsonText(c.host) + "\"";
+  json += ",\"port\":" + String(c.port);
+  json += ",\"user\":\"" + jsonText(c.user) + "\"";
+  json += ",\"base\":\"" + jsonText(c.base) + "\"";
+  json += ",\"interval\":" + String(c.intervalMs);
+  json += ",\"connected\":" + String(mqttConnected ? "true" : "false");
+  json += ",\"queued\":" + String((mqttSamples ? uxQueueMessagesWaiting(mqttSamples) : 0) + mqttPendingCount);
+  json += ",\"dropped\":" + String(mqttDropped);
+  json += ",\"published\":" + String(mqttPublished);
+  json += ",\"reconnects\":" + String(mqttReconnects) + "}";
+  server.send(200, "application/json", json);
+}
 
-  if (selected) {
-    tft.fillRoundRect(10, y - 2, 300, lineH, 8, COLOR_MENU2_ACCENT);
-    tft.setTextColor(COLOR_BG);
-  } else {
-    tft.fillRoundRect(10, y - 2, 300, lineH, 8, COLOR_BG);
-    tft.drawRoundRect(10, y - 2, 300, lineH, 8, COLOR_MENU2_ACCENT);
-    tft.setTextColor(COLOR_TEXT);
+// POST /api/mqtt – enabled, host, port, user, pass, base, interval (ms)
+void handleMqttPost() {
+  MqttConfig c = mqttCfg;
+  if (server.hasArg("enabled"))  c.enabled = server.arg("enabled") == "1" || server.arg("enabled") == "true";
+  if (server.hasArg("host"))     strlcpy(c.host, server.arg("host").c_str(), sizeof(c.host));
+  if (server.hasArg("port"))     c.port = server.arg("port").toInt();
+  if (server.hasArg("user"))     strlcpy(c.user, server.arg("user").c_str(), sizeof(c.user));
+  if (server.hasArg("pass"))     strlcpy(c.pass, server.arg("pass").c_str(), sizeof(c.pass));
+  if (server.hasArg("base"))     strlcpy(c.base, server.arg("base").c_str(), sizeof(c.base));
+  if (server.hasArg("interval")) c.intervalMs = server.arg("interval").toInt();
+
+  if (c.port == 0 || c.intervalMs < 100) {
+    server.send(400, "text/plain", "Bad 'port' or 'interval' (min 100 ms)");
+    return;
   }
 
-  tft.setTextSize(2);
-  tft.setCursor(20, y + 2);
-  tft.print(MENU2_LABELS[index]);
+  saveMqttConfig(c);
+  loadMqttConfig();
+  server.send(200, "text/plain", "OK");
 }
 
-void drawMenu2Screen() {
-  tft.fillScreen(COLOR_BG);
-
-  // top bar ve zluté
-  tft.fillRect(0, 0, 320, 24, COLOR_MENU2_ACCENT);
-  tft.setTextColor(COLOR_BG);
-  tft.setTextSize(1);
-  tft.setCursor(4, 6);
-  tft.print("MENU2");
+void handleStreamGet() {
+  String json = "{";
+  json += "\"enabled\":" + String(streamCfg.enabled ? "true" : "false");
+  json += ",\"host\":\"" + streamCfg.host.toString() + "\"";
+  json += ",\"port\":" + String(streamCfg.port);
+  json += ",\"batch\":" + String(streamCfg.batch);
+  json += ",\"boot_id\":" + String(streamBootId);
+  json += ",\"seq\":" + String(streamWriter.nextSeq());
+  json += ",\"packets\":" + String(streamPackets);
+  json += ",\"send_errors\":" + String(streamSendErrs);
+  json += "}";
+  server.send(200, "application/json", json);
+}
 
-  for (int i = 0; i < MENU2_ITEMS; i++) {
-    drawMenu2Item(i, i == menu2Index);
+// POST /api/stream  enabled=1&host=239.1.2.3&port=5005&batch=8
+void handleStreamPost() {
+  StreamConfig c = streamCfg;
+  if (server.hasArg("enabled")) c.enabled = server.arg("enabled") == "1" || server.arg("enabled") == "true";
+  if (server.hasArg("host") && !c.host.fromString(server.arg("host"))) {
+    server.send(400, "text/plain", "Bad 'host' (IPv4 address)");
+    return;
+  }
+  if (server.hasArg("port")) c.port = (uint16_t)server.arg("port").toInt();
+  if (server.hasArg("batch")) {
+    long b = server.arg("batch").toInt();
+    c.batch = (uint8_t)(b < 1 ? 1 : (b > STREAM_MAX_BATCH ? STREAM_MAX_BATCH : b));
+  }
+  if (c.port == 0) {
+    server.send(400, "text/plain", "Bad 'port'");
+    return;
   }
 
-  tft.setTextSize(1);
-  tft.setTextColor(COLOR_TEXT);
-  tft.setCursor(4, 224);
-  tft.print("Otacej, stisk pro potvrzeni");
+  // rozpracovaný paket zahodit, další ponese SP_RESYNC
+  streamCfg = c;
+  streamWriter.begin(streamBootId, LOAD_CELL_COUNT, streamCfg.batch);
+  saveStreamConfig();
+  handleStreamGet();
+}
+
+// /api/wifi – stav spojení, cache AP a statistika výpadků
+void handleWifiGet() {
+  WifiCache c = wifiCacheGet();
+  bool up = WiFi.status() == WL_CONNECTED;
+  String json = "{";
+  json += "\"state\":\"" + String(WR_STATE_NAMES[wifiState]) + "\"";
+  json += ",\"ssid\":\"" + jsonText(up ? WiFi.SSID() : c.ssid) + "\"";
+  json += ",\"bssid\":\"" + (up ? WiFi.BSSIDstr() : String()) + "\"";
+  json += ",\"channel\":" + String(up ? WiFi.channel() : 0);
+  json += ",\"rssi\":" + String(up ? WiFi.RSSI() : 0);
+  json += ",\"ip\":\"" + WiFi.localIP().toString() + "\"";
+  json += ",\"hostname\":\"" + String(deviceId) + "\"";
+  json += ",\"cache\":{\"valid\":" + String(c.valid ? "true" : "false");
+  json += ",\"channel\":" + String(c.channel);
+  json += ",\"static\":" + String(c.useStatic ? "true" : "false");
+  json += ",\"ip\":\"" + c.ip.toString() + "\"";
+  json += ",\"gateway\":\"" + c.gw.toString() + "\"";
+  json += ",\"mask\":\"" + c.mask.toString() + "\"";
+  json += ",\"dns\":\"" + c.dns.toString() + "\"}";
+  json += ",\"boot_connect_ms\":" + String(wifiBootConnectMs);
+  json += ",\"boot_fast\":" + String(wifiBootFast ? "true" : "false");
+  json += ",\"disconnects\":" + String(wifiDisconnects);
+  json += ",\"reconnects\":" + String(wifiReconnects);
+  json += ",\"attempts\":" + String(wifiAttempts);
+  json += ",\"fast_reconnects\":" + String(wifiFastOk);
+  json += ",\"last_reason\":" + String(wifiLastReason);
+  json += ",\"last_outage_ms\":" + String(wifiLastOutageMs);
+  json += ",\"max_outage_ms\":" + String(wifiMaxOutageMs);
+  json += ",\"down_ms\":" + String(wifiState == WR_UP ? 0 : millis() - wifiDownSinceMs);
+  json += "}";
+  server.send(200, "application/json", json);
 }
 
-void updateMenu2SelectionFromEncoder() {
-  long diff = encoderPosition - menuEncStart;
-  int newIndex = (int)diff;
+// POST /api/wifi  static=1[&ip=..&gateway=..&mask=..&dns=..] | static=0 | forget=1
+// bez ip se pro static=1 vezme poslední DHCP lease; platí od dalšího připojení.
+// forget=1 zapomene AP (BSSID, kanál) a smaže údaje z NVS – v RAM zůstanou,
+// aby se po výpadku dalo připojit (se skenem); po připojení se AP uloží znovu.
+void handleWifiPost() {
+  WifiCache c = wifiCacheGet();
+  bool forget = server.arg("forget") == "1";
+  if (forget) {
+    c.valid = false;
+    memset(c.bssid, 0, sizeof(c.bssid));
+    c.channel = 0;
+  }
+  if (server.hasArg("static")) c.useStatic = server.arg("static") == "1" || server.arg("static") == "true";
 
-  if (newIndex < 0) newIndex = 0;
-  if (newIndex >= MENU2_ITEMS) newIndex = MENU2_ITEMS - 1;
+  const char* keys[4] = { "ip", "gateway", "mask", "dns" };
+  IPAddress* dst[4]   = { &c.ip, &c.gw, &c.mask, &c.dns };
+  for (int i = 0; i < 4; i++) {
+    if (server.hasArg(keys[i]) && !dst[i]->fromString(server.arg(keys[i]))) {
+      server.send(400, "text/plain", String("Bad '") + keys[i] + "' (IPv4 address)");
+      return;
+    }
+  }
+  if (c.useStatic && ((uint32_t)c.ip == 0 || (uint32_t)c.mask == 0)) {
+    server.send(400, "text/plain", "Static IP needs 'ip' and 'mask'");
+    return;
+  }
 
-  if (newIndex != menu2Index) {
-    drawMenu2Item(menu2Index, false);
-    drawMenu2Item(newIndex, true);
-    menu2Index = newIndex;
+  wifiCacheSet(c);
+  if (forget) {
+    WifiCache stored = c;
+    stored.ssid = String();
+    stored.psk  = String();
+    saveWifiCache(stored);
+  } else {
+    saveWifiCache(c);
   }
+  handleWifiGet();
 }
 
-// ========================
-// TAR – zobrazení
-// ========================
-void drawTarMessage() {
-  eraseWeightArea();
+// /api/recipe – kroky receptu, průběh a log dokončených kroků
+void handleRecipeGet() {
+  String json = "{\"active\":" + String(recipeMode ? "true" : "false");
+  json += ",\"finished\":" + String(recipe.finished() ? "true" : "false");
+  json += ",\"step\":" + String(recipe.currentStep() + 1);
+  json += ",\"steps\":[";
+  for (int i = 0; i < recipe.stepCount(); i++) {
+    const RecipeStep& st = recipe.step(i);
+    const char* status = i < recipe.currentStep() ? "done" : (i == recipe.currentStep() && recipeMode ? "current" : "pending");
+    if (i > 0) json += ",";
+    json += "{\"name\":\"" + String(st.name) + "\"";
+    json += ",\"target\":" + weightText(st.targetMg);
+    json += ",\"tolerance\":" + weightText(st.tolMg);
+    json += ",\"status\":\"" + String(status) + "\"";
+    json += ",\"progress\":" + String(recipeMode ? recipe.progressPermille(i) / 10.0f : 0.0f, 1) + "}";
+  }
+  json += "],\"log\":[";
+  for (int i = 0; i < recipe.currentStep() && i < recipe.stepCount(); i++) {
+    const RecipeStep& st = recipe.step(i);
+    if (st.durationMs == 0) break;     // zastavený recept bez dokončených kroků
+    if (i > 0) json += ",";
+    json += "{\"step\":" + String(i + 1);
+    json += ",\"name\":\"" + String(st.name) + "\"";
+    json += ",\"target\":" + weightText(st.targetMg);
+    json += ",\"actual\":" + weightText(st.actualMg);
+    json += ",\"error\":" + weightText(st.actualMg - st.targetMg);
+    json += ",\"duration_ms\":" + String(st.durationMs);
+    json += ",\"epoch\":" + String(st.doneEpoch);
+    json += ",\"manual\":" + String(st.manual ? "true" : "false") + "}";
+  }
+  json += "]}";
+  server.send(200, "application/json", json);
+}
 
-  tft.setTextSize(4);
-  tft.setTextColor(COLOR_ACCENT);
+// POST /api/recipe – text receptu (pole "recipe" nebo tělo text/plain),
+// řádek = jmeno,gramy[,tolerance_g]; start=0 jen uloží, jinak hned spustí
+void handleRecipePost() {
+  String text = server.hasArg("recipe") ? server.arg("recipe") : server.arg("plain");
+  if (text.length() == 0 || text.length() > 2048) {
+    server.send(400, "text/plain", "Missing or too long 'recipe'");
+    return;
+  }
+  int errLine;
+  if (!recipe.parse(text.c_str(), errLine)) {
+    server.send(400, "text/plain", "Bad recipe line " + String(errLine) + " (name,grams[,tolerance])");
+    return;
+  }
+  recipeMode = false;
 
-  const char* txt = "TAR";
-  int len = strlen(txt);
-  int charW = 6 * 4; // 6 px * size4
-  int totalW = len * charW;
+  File f = LittleFS.open(RECIPE_FILE_PATH, "w");
+  if (f) {
+    f.print(text);
+    f.close();
+  }
 
-  int boxX = 20;
-  int boxW = 280;
-  int x = boxX + (boxW - totalW) / 2;
-  int y = 90;
+  if (!server.hasArg("start") || server.arg("start") != "0") {
+    setDynamicMode(false);
+    stopCounting();
+    startRecipe();
+  }
+  hudRedrawPending = true;
+  stateVersion++;
+  handleRecipeGet();
+}
 
-  tft.setCursor(x, y);
-  tft.print(txt);
+// POST /api/recipe/start – znovu od prvního kroku s tím, co je na váze
+void handleRecipeStart() {
+  if (recipe.stepCount() == 0) {
+    server.send(409, "text/plain", "No recipe");
+    return;
+  }
+  setDynamicMode(false);
+  stopCounting();
+  startRecipe();
+  hudRedrawPending = true;
+  server.send(200, "text/plain", "OK");
 }
 
-// ========================
-// HTTP handlery
-// ========================
-void handleRoot() {
-  server.send_P(200, "text/html; charset=utf-8", INDEX_HTML);
+// POST /api/recipe/next – potvrdit aktuální krok tak, jak je (i mimo toleranci)
+void handleRecipeNext() {
+  if (!recipeMode || !recipe.confirm(millis(), clockEpoch())) {
+    server.send(409, "text/plain", "Recipe not running");
+    return;
+  }
+  logRecipeStep(recipe.currentStep() - 1);
+  stateVersion++;
+  server.send(200, "text/plain", "OK");
 }
 
-void handleState() {
-  updateWeightFromScale();
-  int rssi = (WiFi.status() == WL_CONNECTED) ? WiFi.RSSI() : 0;
+void handleRecipeStop() {
+  stopRecipe();
+  hudRedrawPending = true;
+  server.send(200, "text/plain", "OK");
+}
 
-  String json = "{";
-  json += "\"weight\":" + String(currentWeight, 2) + ",";
-  json += "\"item\":\"" + currentItem + "\",";
-  json += "\"rssi\":" + String(rssi);
+// /api/check – konfigurace a statistika kontrolního vážení
+void handleCheckGet() {
+  const CheckWeighParams& p = checkWeigher.getParams();
+  const CheckWeighStats& st = checkWeigher.getStats();
+  uint32_t settled = st.total - st.unsettled;
+
+  String json = "{\"enabled\":" + String(checkMode ? "true" : "false");
+  json += ",\"target\":" + weightText(p.targetMg);
+  json += ",\"under\":" + weightText(p.underMg);
+  json += ",\"over\":" + weightText(p.overMg);
+  json += ",\"load\":" + weightText(p.loadMg);
+  json += ",\"band\":" + weightText(p.settleBandMg);
+  json += ",\"settle_samples\":" + String(p.settleSamples);
+  json += ",\"window_ms\":" + String(p.windowUs / 1000);
+  json += ",\"state\":\"" + String(checkStateName()) + "\"";
+  json += ",\"zero\":" + weightText(checkWeigher.getZeroMg());
+  json += ",\"verdict\":\"" + String(checkVerdictName(checkWeigher.getVerdict())) + "\"";
+  json += ",\"last\":" + weightText(checkWeigher.getLastMg());
+  json += ",\"total\":" + String(st.total);
+  json += ",\"pass\":" + String(st.pass);
+  json += ",\"under_count\":" + String(st.under);
+  json += ",\"over_count\":" + String(st.over);
+  json += ",\"unsettled\":" + String(st.unsettled);
+  json += ",\"aborted\":" + String(st.aborted);
+  json += ",\"pass_rate\":" + String(st.total ? 100.0f * st.pass / st.total : 0.0f, 1);
+  json += ",\"items_per_min\":" + String(checkWeigher.itemsPerMinute(esp_timer_get_time()), 1);
+  json += ",\"mean\":" + (settled ? weightText((int32_t)lround(st.mean)) : String("null"));
+  json += ",\"stddev\":" + String(checkWeigher.stddevMg() / 1000.0, 3);
+  json += ",\"settle_ms_avg\":" + String(checkWeigher.meanSettleUs() / 1000.0f, 1);
+  json += ",\"settle_ms_max\":" + String(st.settleUsMax / 1000.0f, 1);
   json += "}";
   server.send(200, "application/json", json);
 }
 
-void handleItemPost() {
-  if (server.hasArg("item")) {
-    currentItem = server.arg("item");
-    Serial.print("New item: ");
-    Serial.println(currentItem);
-    server.send(200, "text/plain", "OK");
-  } else {
-    server.send(400, "text/plain", "Missing 'item'");
+// POST /api/check  enabled=1&target=250&under=2&over=5 (gramy)
+//                  [&load=G&band=G&settle=N&window=MS]
+void handleCheckPost() {
+  CheckWeighParams p = checkWeigher.getParams();
+  bool on = checkMode;
+  if (server.hasArg("enabled")) on = server.arg("enabled") == "1" || server.arg("enabled") == "true";
+  if (server.hasArg("target"))  p.targetMg     = wpGramsToMg(server.arg("target").toFloat());
+  if (server.hasArg("under"))   p.underMg      = wpGramsToMg(server.arg("under").toFloat());
+  if (server.hasArg("over"))    p.overMg       = wpGramsToMg(server.arg("over").toFloat());
+  if (server.hasArg("load"))    p.loadMg       = wpGramsToMg(server.arg("load").toFloat());
+  if (server.hasArg("band"))    p.settleBandMg = wpGramsToMg(server.arg("band").toFloat());
+  if (server.hasArg("settle"))  p.settleSamples = server.arg("settle").toInt();
+  if (server.hasArg("window"))  p.windowUs     = (uint32_t)server.arg("window").toInt() * 1000;
+
+  if (p.targetMg <= 0 || p.underMg < 0 || p.overMg < 0 || p.loadMg < 0 || p.settleBandMg <= 0) {
+    server.send(400, "text/plain", "Bad 'target', 'under', 'over', 'load' or 'band'");
+    return;
+  }
+  if (p.settleSamples < 2 || p.settleSamples > CheckWeigher::MAX_SETTLE ||
+      p.windowUs < 100000 || p.windowUs > 10000000) {
+    server.send(400, "text/plain", "Bad 'settle' (2-16) or 'window' (100-10000 ms)");
+    return;
+  }
+
+  // jiný cíl = jiná šarže, statistika od nuly
+  bool newTarget = p.targetMg != checkWeigher.getParams().targetMg;
+  checkWeigher.setParams(p);
+  if (on != checkMode) {
+    checkMode = on;
+    checkWeigher.reset();         // nula se chytí z prázdné plošiny
+    if (on) {
+      setDynamicMode(false);
+      stopCounting();
+      stopRecipe();
+    }
+    applyHx711Rate();
+    hudRedrawPending = true;
+    Serial.println(on ? "[CHECK] zapnuto" : "[CHECK] vypnuto");
   }
+  if (newTarget) checkWeigher.resetStats();
+  lastDrawnCheckTotal = UINT32_MAX;
+  saveCheckConfig();
+  stateVersion++;
+  handleCheckGet();
 }
 
-// /api_json – tvoje API
-void handleApiJson() {
-  updateWeightFromScale();
+// POST /api/check/reset – vynulovat počty (nová směna / šarže)
+void handleCheckReset() {
+  checkWeigher.resetStats();
+  lastDrawnCheckTotal = UINT32_MAX;
+  stateVersion++;
+  server.send(200, "text/plain", "OK");
+}
+
+// GET /api/screenshot?format=bmp|png – co je právě na displeji
+void handleScreenshot() {
+  if (!shotTaskHandle) {
+    server.send(503, "text/plain", "Screenshot not available (no PSRAM)");
+    return;
+  }
+  if (shotBusy) {
+    server.sendHeader("Retry-After", "1");
+    server.send(503, "text/plain", "Screenshot in progress");
+    return;
+  }
+  String f = server.arg("format");
+  if (f.length() > 0 && f != "bmp" && f != "png") {
+    server.send(400, "text/plain", "Bad 'format' (bmp, png)");
+    return;
+  }
+
+  // odpověď pošle task; WebServer o spojení přijde, ale kopie v shotClient
+  // ho drží otevřené, dokud task neskončí
+  shotFormat = f == "png" ? SE_PNG : SE_BMP;
+  shotClient = server.client();
+  shotBusy   = true;
+  xTaskNotifyGive(shotTaskHandle);
+}
+
+// /api/stalls – záznamy watchdogu (nejnovější poslední)
+void handleStallsGet() {
+  String json = "{\"boot\":" + String(wdRing.bootCount);
+  json += ",\"reset_reason\":" + String((int)wdResetReason);
+  json += ",\"tasks\":[";
+  for (int i = 0; i < wdTaskCount; i++) {
+    if (i > 0) json += ",";
+    json += "{\"name\":\"" + String(wdTasks[i].name) + "\",\"limit_ms\":" + String(wdTasks[i].limitMs);
+    json += ",\"silent_ms\":" + String(millis() - wdTasks[i].lastBeatMs) + "}";
+  }
+  json += "],\"stalls\":[";
+  for (uint32_t i = 0; i < wdRing.count; i++) {
+    const WdRecord& r = wdRing.rec[(wdRing.head + WD_RECORDS - wdRing.count + i) % WD_RECORDS];
+    char stack[64];
+    wdStackString(r.stack, r.depth, stack, sizeof(stack));
+    if (i > 0) json += ",";
+    json += "{\"boot\":" + String(r.boot);
+    json += ",\"uptime_ms\":" + String(r.uptimeMs);
+    json += ",\"duration_ms\":" + String(r.durationMs);
+    json += ",\"task\":\"" + String(r.task) + "\"";
+    json += ",\"stages\":\"" + String(stack) + "\"";
+    json += ",\"ongoing\":" + String(r.ongoing && r.boot == wdRing.bootCount ? "true" : "false");
+    json += ",\"ended_by_reset\":" + String(r.ongoing && r.boot != wdRing.bootCount ? "true" : "false");
+    json += ",\"free_heap\":" + String(r.freeHeap);
+    json += ",\"min_free_heap\":" + String(r.minFreeHeap);
+    json += ",\"max_alloc_heap\":" + String(r.maxAllocHeap) + "}";
+  }
+  json += "]}";
+  server.send(200, "application/json", json);
+}
+
+void handleStallsClear() {
+  wdClear();
+  server.send(200, "text/plain", "OK");
+}
 
+// /api/http – statistika cache a limitu
+void handleHttpStats() {
   String json = "{";
-  json += "\"weight\":" + String(currentWeight, 2) + ",";
-  json += "\"item\":\"" + currentItem + "\",";
-  json += "\"date\":\"" + getDateString() + "\",";
-  json += "\"time\":\"" + getTimeString() + "\"";
+  json += "\"cache_hits\":" + String(httpCacheHits);
+  json += ",\"cache_builds\":" + String(httpCacheBuilds);
+  json += ",\"not_modified\":" + String(httpNotModified);
+  json += ",\"rate_limited\":" + String(httpRateLimited);
+  json += ",\"rate_per_s\":" + String(RATE_PER_SEC, 1);
+  json += ",\"burst\":" + String(RATE_BURST, 0);
+  json += ",\"state_version\":" + String(stateVersion);
+  json += ",\"screenshots\":" + String(shotCount);
+  json += ",\"screenshot_errors\":" + String(shotErrors);
+  json += ",\"screenshot_ms\":" + String(shotLastMs);
   json += "}";
   server.send(200, "application/json", json);
 }
@@ -888,41 +4992,54 @@ void handleNotFound() {
 void enterHudMode() {
   uiMode = UI_HUD;
   drawStaticHUD();
-  lastDrawnWeight = 999999.0f;
+  lastDrawnWeightMg = WEIGHT_NONE;
+  for (int z = 0; z < ZONE_COUNT; z++) lastDrawnZoneMg[z] = WEIGHT_NONE;
   lastWifiLevel   = -1;
-  lastTimeStr     = "";
-  lastDateStr     = "";
+  lastDrawnDynState = -1;
+  lastDrawnContainer = -2;
+  lastDrawnClock  = UINT32_MAX;
+  lastDrawnBtn    = -1;
+  lastDrawnCheckTotal = UINT32_MAX;
+  lastDrawnCheckState = -1;
+  lastDrawnCountState = -1;
+  lastDrawnRecipeStep = -1;
+  hudRedrawPending    = false;
+  hudForceFrame   = true;
+  trendFullRedraw = true;
   tarActive       = false;
   tarDrawn        = false;
-  hudEncStart     = encoderPosition;
-  lastHudEncoderMoveMs = millis();
-  hudEncLastPos        = encoderPosition;
+  hudGesture.reset(encoder.position(), millis());
 }
 
 
 void enterMenuMode() {
   uiMode = UI_MENU;
-  menuEncStart = encoderPosition;
-  menuIndex    = 0;
+  listBegin(mainMenu, MENU_ITEMS, COLOR_TOPBAR2, mainMenuLabel);
   drawMenuScreen();
 }
 
 void enterTareMenuMode() {
   uiMode = UI_MENU_TARE;
-  menuEncStart  = encoderPosition;
-  menuTareIndex = 0;
+  listBegin(tareMenu, tareMenuCount(), COLOR_MENU_TARE_ACCENT, tareMenuLabel, tareMenuMarked);
+  learnContainer = -1;
   drawTareMenuScreen();
 }
 
 void enterMenu2Mode() {
   uiMode = UI_MENU2;
-  menuEncStart = encoderPosition;
-  menu2Index   = 0;
+  listBegin(foodMenu, foodDb.count() + 1, COLOR_MENU2_ACCENT, foodMenuLabel, nullptr, foodMenuJump);
   drawMenu2Screen();
 }
 
+void enterCountMenuMode() {
+  uiMode = UI_MENU_COUNT;
+  listBegin(countMenu, countMenuCount(), COLOR_ACCENT, countMenuLabel, countMenuMarked);
+  drawCountMenuScreen();
+}
+
 void handleMenuSelection() {
-  const char* sel = MENU_LABELS[menuIndex];
+  if (mainMenu.index < 0 || mainMenu.index >= MENU_ITEMS) return;
+  const char* sel = MENU_LABELS[mainMenu.index];
 
   if (strcmp(sel, "Kalibrace") == 0) {
     Serial.println("[MENU] Kalibrace (zatim nic nedelej)");
@@ -930,6 +5047,10 @@ void handleMenuSelection() {
   } else if (strcmp(sel, "Resetovat WiFi") == 0) {
     Serial.println("[MENU] Resetovat WiFi (zatim nic nedelej)");
     // tady potom dáme WiFiManager reset
+  } else if (strcmp(sel, "Pocitani kusu") == 0) {
+    Serial.println("[MENU] Pocitani kusu");
+    enterCountMenuMode();
+    return;
   } else if (strcmp(sel, "Zpet") == 0) {
     Serial.println("[MENU] Zpet -> HUD");
     enterHudMode();
@@ -940,32 +5061,86 @@ void handleMenuSelection() {
 }
 
 void handleTareMenuSelection() {
-  const char* sel = MENU_TARE_LABELS[menuTareIndex];
+  if (learnContainer >= 0) return;  // učení běží
 
-  if (strcmp(sel, "Zpet") == 0) {
+  if (tareMenu.index == 0) {
     Serial.println("[MENU_TARE] Zpet -> HUD");
     enterHudMode();
     return;
   }
 
+  if (tareMenu.index == 1) {
+    Serial.println("[MENU_TARE] Bez nadoby");
+    applyContainer(-1);
+    enterHudMode();
+    return;
+  }
+
+  if (tareMenu.index == tareMenuCount() - 1) {
+    char name[24];
+    snprintf(name, sizeof(name), "Nadoba %d", containerCount + 1);
+    int idx = addContainer(name, 0.0f);
+    if (idx < 0) {
+      drawTareMenuHint("Tabulka nadob je plna");
+      return;
+    }
+    startContainerLearn(idx);
+    drawTareMenuRows();
+    drawTareMenuHint("Poloz prazdnou nadobu, cekam...");
+    return;
+  }
+
+  // tabulka se mohla změnit přes HTTP, zatímco bylo menu otevřené
+  int idx = tareMenu.index - 2;
+  if (idx < 0 || idx >= containerCount) {
+    listSetCount(tareMenu, tareMenuCount());
+    return;
+  }
+  if (containers[idx].grams <= 0.0f) {
+    // ještě nenaučená -> naučit z toho, co leží na váze
+    startContainerLearn(idx);
+    drawTareMenuHint("Poloz prazdnou nadobu, cekam...");
+    return;
+  }
+
+  // známá nádoba -> tara hned, bez čekání na ustálení
   Serial.print("[MENU_TARE] Vybrano: ");
-  Serial.println(sel);
-  // zatím nic nedělá – jen placeholder do budoucna
+  Serial.println(containers[idx].name);
+  applyContainer(idx);
+  enterHudMode();
 }
 
+// dlouhý stisk na nádobě = přeučit
+void handleTareMenuLongPress() {
+  int idx = tareMenu.index - 2;
+  if (learnContainer >= 0 || idx < 0 || idx >= containerCount) return;
+  startContainerLearn(idx);
+  drawTareMenuHint("Poloz prazdnou nadobu, cekam...");
+}
 
-void handleMenu2Selection() {
-  const char* sel = MENU2_LABELS[menu2Index];
+void handleCountMenuSelection() {
+  if (countMenu.index == 0) {
+    Serial.println("[MENU_COUNT] Zpet -> HUD");
+  } else if (countMenu.index <= COUNT_REF_OPTIONS) {
+    setDynamicMode(false);
+    stopRecipe();
+    startCounting(COUNT_REF_PIECES[countMenu.index - 1]);
+  } else {
+    stopCounting();
+  }
+  enterHudMode();
+}
 
-  if (strcmp(sel, "Zpet") == 0) {
+void handleMenu2Selection() {
+  if (foodMenu.index == 0) {
     Serial.println("[MENU2] Zpet -> HUD");
     enterHudMode();
     return;
   }
 
-  Serial.print("[MENU2] Vybrano: ");
-  Serial.println(sel);
-  // zatím nic nedělá – jen placeholder
+  if ((uint32_t)foodMenu.index > foodDb.count()) return;
+  selectFood(foodDb.byNamePos(foodMenu.index - 1));
+  enterHudMode();
 }
 
 
@@ -978,17 +5153,21 @@ void setup() {
   Serial.println();
   Serial.println("Chytra vaha - WiFi portal + HUD + menu");
 
+  // záznamy zaseknutí z minulých běhů (hlídání startuje až na konci setup)
+  setupWatchdog();
+
   // PINy enkoderu
   pinMode(ENC_SW, INPUT_PULLUP);
   pinMode(ENC_A,  INPUT_PULLUP);
   pinMode(ENC_B,  INPUT_PULLUP);
-  lastEncA        = digitalRead(ENC_A);
-  lastButtonState = digitalRead(ENC_SW);
+  encoder.begin(digitalRead(ENC_A) == HIGH, digitalRead(ENC_B) == HIGH, millis());
+  button.begin(digitalRead(ENC_SW) == HIGH, millis());
 
   // LCD – ST7789 240x320
   SPI.begin(TFT_SCK, -1, TFT_MOSI, TFT_CS);
   tft.init(240, 320);
   tft.setRotation(1);      // landscape 320x240
+  setupScreenshot();       // stínový buffer ještě před prvním kreslením
   tft.fillScreen(COLOR_BG);
   tft.setTextColor(COLOR_TEXT);
   tft.setTextSize(1);
@@ -998,18 +5177,40 @@ void setup() {
   // HX711
   tft.setCursor(10, 30);
   tft.println("HX711 init");
-  scale.begin(HX711_DOUT, HX711_SCK);
-  scale.set_scale(1.0f); // bez kalibrace
-  scale.tare();
+  if (!LittleFS.begin(true)) {
+    Serial.println("LittleFS mount failed");
+  }
+
+  setupLoadCells();
+  if (HX711_RATE >= 0) {
+    pinMode(HX711_RATE, OUTPUT);
+    digitalWrite(HX711_RATE, LOW);
+  }
+  loadCellCalibration();
+  loadCheckConfig();
+  loadContainers();
+  loadRecipe();
+  openFoodDb();
+  tareLoadCells(10);
   delay(200);
 
   // WiFi portal – konfig domácí WiFi
   tft.setCursor(10, 50);
   tft.println("WiFi portal...");
+  setupDeviceId();
+  loadWifiCache();
+  WiFi.persistent(false);       // přihlašovací údaje drží cache / WiFiManager
+  WiFi.setHostname(deviceId);
   WiFi.mode(WIFI_STA);
-  WiFiManager wm;
-  wm.setConfigPortalBlocking(true);
-  bool res = wm.autoConnect("Smart_scale SETUP", "calories");
+  bool res = wifiFastConnect();
+  if (!res) {
+    unsigned long startMs = millis();
+    WiFi.persistent(true);
+    WiFiManager wm;
+    wm.setConfigPortalBlocking(true);
+    res = wm.autoConnect("Smart_scale SETUP", "calories");
+    wifiBootConnectMs = millis() - startMs;
+  }
 
   if (!res) {
     tft.setCursor(10, 70);
@@ -1021,16 +5222,29 @@ void setup() {
   tft.setCursor(10, 70);
   tft.print("WiFi OK: ");
   tft.println(WiFi.localIP());
+  setupWifiRecovery();
 
   // NTP time
   tft.setCursor(10, 90);
   tft.println("NTP sync...");
+  setupClock();
   configTime(gmtOffset_sec, daylightOffset_sec, "pool.ntp.org", "time.nist.gov");
 
-  // mDNS vaha.local
-  if (MDNS.begin("vaha")) {
+  // MQTT – vlastní task, čeká na WiFi sám
+  setupMqtt();
+
+  // binární UDP stream vzorků (když je zapnutý v /api/stream)
+  setupStream();
+
+  // mDNS <deviceId>.local – každá váha vlastní jméno, ať se v síti nepřetahují
+  if (MDNS.begin(deviceId)) {
+    MDNS.setInstanceName(String("Chytra vaha ") + deviceId);
     MDNS.addService("http", "tcp", 80);
-    Serial.println("mDNS responder started: http://vaha.local");
+    MDNS.addService("vaha", "tcp", 80);
+    MDNS.addServiceTxt("vaha", "tcp", "id", deviceId);
+    MDNS.addServiceTxt("vaha", "tcp", "caps", FLEET_CAPS);
+    Serial.printf("mDNS responder started: http://%s.local\n", deviceId);
+    setupFleet();
   } else {
     Serial.println("Error setting up MDNS responder!");
   }
@@ -1040,32 +5254,81 @@ void setup() {
   server.on("/api/state", HTTP_GET, handleState);
   server.on("/api/item", HTTP_POST, handleItemPost);
   server.on("/api_json", HTTP_GET, handleApiJson);
+  server.on("/api/cells", HTTP_GET, handleCellsGet);
+  server.on("/api/cells/calibrate", HTTP_POST, handleCellsCalibrate);
+  server.on("/api/containers", HTTP_GET, handleContainersGet);
+  server.on("/api/containers", HTTP_POST, handleContainersPost);
+  server.on("/api/containers/delete", HTTP_POST, handleContainersDelete);
+  server.on("/api/containers/apply", HTTP_POST, handleContainersApply);
+  server.on("/api/foods", HTTP_GET, handleFoodsSearch);
+  server.on("/api/food", HTTP_POST, handleFoodSelect);
+  server.on("/api/mqtt", HTTP_GET, handleMqttGet);
+  server.on("/api/mqtt", HTTP_POST, handleMqttPost);
+  server.on("/api/stream", HTTP_GET, handleStreamGet);
+  server.on("/api/stream", HTTP_POST, handleStreamPost);
+  server.on("/api/recipe", HTTP_GET, handleRecipeGet);
+  server.on("/api/recipe", HTTP_POST, handleRecipePost);
+  server.on("/api/recipe/start", HTTP_POST, handleRecipeStart);
+  server.on("/api/recipe/next", HTTP_POST, handleRecipeNext);
+  server.on("/api/recipe/stop", HTTP_POST, handleRecipeStop);
+  server.on("/api/check", HTTP_GET, handleCheckGet);
+  server.on("/api/check", HTTP_POST, handleCheckPost);
+  server.on("/api/check/reset", HTTP_POST, handleCheckReset);
+  server.on("/api/stalls", HTTP_GET, handleStallsGet);
+  server.on("/api/stalls/clear", HTTP_POST, handleStallsClear);
+  server.on("/api/http", HTTP_GET, handleHttpStats);
+  server.on("/api/screenshot", HTTP_GET, handleScreenshot);
+  server.on("/api/summary", HTTP_GET, handleSummary);
+  server.on("/api/fleet", HTTP_GET, handleFleet);
+  server.on("/api/wifi", HTTP_GET, handleWifiGet);
+  server.on("/api/wifi", HTTP_POST, handleWifiPost);
+  server.on("/fleet", HTTP_GET, handleFleetPage);
+  server.on("/api/trace/start", HTTP_POST, handleTraceStart);
+  server.on("/api/trace/stop", HTTP_POST, handleTraceStop);
+  server.on("/api/trace", HTTP_GET, handleTraceDownload);
   server.onNotFound(handleNotFound);
+
+  // WebServer si nechává jen vyjmenované hlavičky (kvůli ETag / 304)
+  static const char* COLLECT_HEADERS[] = { "If-None-Match" };
+  server.collectHeaders(COLLECT_HEADERS, 1);
   server.begin();
   Serial.println("HTTP server started");
 
   enterHudMode();
+  startWatchdog();
 }
 
 // ========================
 // Loop
 // ========================
 void loop() {
-  server.handleClient();
+  wdBeat(WD_LOOP);
+
+  {
+    WdStage st(WD_LOOP, ST_HTTP);
+    server.handleClient();
+  }
 
   updateEncoder();
   updateWeightFromScale();
+  mqttNoteState();
+
+  uint8_t btnEv  = button.update(digitalRead(ENC_SW) == HIGH, millis());
+  bool clicked   = btnEv & BTN_CLICK;
+  bool longPress = btnEv & BTN_LONG;
 
-  bool clicked = checkButtonClicked();
-  bool longPress = false;
-  if (buttonLongPressEvent) {
-    longPress = true;
-    buttonLongPressEvent = false;
+  if (uiMode == UI_HUD && hudRedrawPending) {
+    enterHudMode();   // kontrolní vážení zapnuté / vypnuté přes HTTP
   }
 
   if (uiMode == UI_HUD) {
-    // dlouhý stisk v HUD -> TAR overlay
-    if (longPress) {
+    // dlouhý stisk při kontrolním vážení = nové počty, jinak TAR overlay
+    if (longPress && checkMode) {
+      Serial.println("[BTN] Long press -> reset pocitadel");
+      checkWeigher.resetStats();
+      lastDrawnCheckTotal = UINT32_MAX;
+      stateVersion++;
+    } else if (longPress) {
       Serial.println("[BTN] Long press -> TAR");
       tarActive   = true;
       tarDrawn    = false;
@@ -1073,29 +5336,20 @@ void loop() {
       // (zatím neděláme scale.tare(), jen vizuál)
     }
 
-    // otoceni enkoderem v HUD -> menu TARE nebo MENU2 (jen když neběží TAR)
-    // otoceni enkoderem v HUD -> menu TARE nebo MENU2 (jen když neběží TAR)
-    if (!tarActive) {
-      // sledování pohybu enkodéru a 2s timeout na „nasbírané“ kroky
-      if (encoderPosition != hudEncLastPos) {
-        hudEncLastPos        = encoderPosition;
-        lastHudEncoderMoveMs = millis();
-      } else {
-        if (millis() - lastHudEncoderMoveMs > 2000) { // 2 s bez pohybu
-          hudEncStart = encoderPosition;              // reset baseline
-        }
-      }
-
-      long diff = encoderPosition - hudEncStart;
-      if (diff >= 5) {
-        Serial.println("[ENC] HUD -> MENU_TARE");
-        enterTareMenuMode();
-        return;  // nevolej v tomto kole HUD kreslení
-      } else if (diff <= -5) {
-        Serial.println("[ENC] HUD -> MENU2");
-        enterMenu2Mode();
-        return;
-      }
+    // otoceni enkoderem v HUD -> menu TARE nebo MENU2 (jen když neběží TAR);
+    // kroky natočené během TAR se nepočítají
+    int gesture = HG_NONE;
+    if (tarActive) hudGesture.reset(encoder.position(), millis());
+    else           gesture = hudGesture.update(encoder.position(), millis());
+
+    if (gesture == HG_UP) {
+      Serial.println("[ENC] HUD -> MENU_TARE");
+      enterTareMenuMode();
+      return;  // nevolej v tomto kole HUD kreslení
+    } else if (gesture == HG_DOWN) {
+      Serial.println("[ENC] HUD -> MENU2");
+      enterMenu2Mode();
+      return;
     }
 
 
@@ -1106,59 +5360,61 @@ void loop() {
     }
   
 
-    static unsigned long lastHudUpdate = 0;
-    if (millis() - lastHudUpdate > 200) {
-      // pokud je aktivní TAR, zobraz hlášku 3s místo váhy
-      if (tarActive) {
-        updateTopBarHUD();
-        updateBottomHUD();
-
-        if (!tarDrawn) {
-          drawTarMessage();
-          tarDrawn = true;
-        }
-
-        if (millis() - tarStartMs >= 3000) {
-          tarActive = false;
-          tarDrawn  = false;
-          lastDrawnWeight = 999999.0f; // vynutíme překreslení váhy
-          hudEncStart          = encoderPosition; // reset baseline pro otáčení v HUD
-          lastHudEncoderMoveMs = millis();
-          hudEncLastPos        = encoderPosition;
-        }        
-      } else {
-        updateTopBarHUD();
-        updateWeightHUD();
-        updateBottomHUD();
-      }
-
-      lastHudUpdate = millis();
+    hudCheckActivity();
+    if (hudFrameDue()) {
+      unsigned long startMs = millis();
+      uint32_t t0 = micros();
+      bool drawn = renderHudFrame();
+      hudNoteFrame(startMs, drawn ? (micros() - t0) | 1 : 0);
     }
 
   } else if (uiMode == UI_MENU) {
     // encoder posouvá položky
-    updateMenuSelectionFromEncoder();
+    listNavigate(mainMenu);
 
     // klik v menu -> potvrzení
     if (clicked) {
       handleMenuSelection();
     }
     // dlouhý stisk v menu zatím ignorujeme
+    if (uiMode == UI_MENU) listRender(mainMenu);
 
   } else if (uiMode == UI_MENU_TARE) {
-    updateTareMenuSelectionFromEncoder();
+    listNavigate(tareMenu);
 
     if (clicked) {
       handleTareMenuSelection();
-      // zatím v menu zůstáváme
+    }
+    if (longPress) {
+      handleTareMenuLongPress();
     }
 
+    // učení nádoby – po ustálení rovnou zpět na HUD s novou tarou
+    LearnResult lr = processContainerLearn();
+    if (lr != LEARN_PENDING) {
+      if (lr == LEARN_DONE) {
+        enterHudMode();
+      } else {
+        drawTareMenuRows();
+        drawTareMenuHint("Nadoba nepolozena / neustalena, zkus znovu");
+      }
+    }
+    if (uiMode == UI_MENU_TARE) listRender(tareMenu);
+
   } else if (uiMode == UI_MENU2) {
-    updateMenu2SelectionFromEncoder();
+    listNavigate(foodMenu);
 
     if (clicked) {
       handleMenu2Selection();
-      // zatím v menu zůstáváme
     }
+    if (uiMode == UI_MENU2) listRender(foodMenu);
+
+  } else if (uiMode == UI_MENU_COUNT) {
+    listNavigate(countMenu);
+
+    if (clicked) {
+      handleCountMenuSelection();
+    }
+    if (uiMode == UI_MENU_COUNT) listRender(countMenu);
   }
 }
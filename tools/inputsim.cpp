@@ -0,0 +1,566 @@
+// ========================
+// Simulace vstupů (tlačítko, enkodér, gesto v HUD, seznamy) na PC
+// ========================
+// Prožene skutečnou logiku z include/input_logic.h simulovaným časem:
+// průběhy pinů (zákmity, rychlé točení, dlouhé držení) se vzorkují tak,
+// jak to dělá loop() – v nepravidelném intervalu, občas s dlouhým
+// zaseknutím – a po každém vzorku se kontrolují invarianty:
+//   - jeden stisk dá nejvýš jednu událost (nikdy klik i dlouhý stisk)
+//   - při čistém vzorkování dá krátký stisk právě klik, dlouhý právě long
+//   - gesto v HUD (1..9 kroků) dá nejvýš jednu událost, od 5 kroků právě jednu
+//   - bez zákmitů a se stíhaným vzorkováním sedí pozice enkodéru
+//   - index seznamu je vždy v [0, count) a v zobrazeném okně
+// Čas začíná kdekoli v rozsahu uint32_t, takže se zkouší i přetečení millis().
+//
+// Překlad:
+//   g++ -O2 -std=c++17 -Iinclude tools/inputsim.cpp -o inputsim
+//
+// Použití:
+//   ./inputsim                      pevná sada scénářů
+//   ./inputsim --fuzz N [--seed S]  N náhodných scénářů, vypíše scénářů/s
+//   ./inputsim --fuzz N --seed S --verbose   podrobnosti o prvním selhání
+//
+// Při selhání vypíše seed scénáře – "--fuzz 1 --seed <ten seed>" ho zopakuje.
+// Návratový kód 0 = vše prošlo, 1 = porušený invariant, 2 = špatné argumenty.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+
+#include "input_logic.h"
+
+static const int LIST_ROWS = 7;    // jako v src/main.cpp
+static bool g_trace = false;       // --verbose při opakování jednoho scénáře
+
+// ========================
+// Náhoda (splitmix64 – rychlá a opakovatelná)
+// ========================
+struct Rng {
+  uint64_t s;
+  explicit Rng(uint64_t seed) : s(seed) {}
+  uint64_t next() {
+    uint64_t z = (s += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+  }
+  // rovnoměrně v [lo, hi]
+  uint32_t range(uint32_t lo, uint32_t hi) { return lo + (uint32_t)(next() % (uint64_t)(hi - lo + 1)); }
+  bool chance(int percent) { return (int)(next() % 100) < percent; }
+};
+
+// ========================
+// Průběh pinů
+// ========================
+enum Pin { PIN_SW = 0, PIN_A = 1, PIN_B = 2 };
+
+struct Edge {
+  uint32_t t;       // relativně k začátku scénáře
+  uint8_t  pin;
+  bool     level;
+};
+
+// fyzický stisk (pro kontrolu "jeden stisk = nejvýš jedna událost")
+struct Press {
+  uint32_t start;
+  uint32_t release;
+};
+
+// fyzické otočení (pro kontrolu gesta)
+struct Burst {
+  uint32_t start;
+  uint32_t end;
+  int      steps;   // se znaménkem
+};
+
+struct Wave {
+  std::vector<Edge>  edges;
+  std::vector<Press> presses;
+  std::vector<Burst> bursts;
+  long netSteps = 0;
+
+  void add(uint32_t t, Pin p, bool level) { edges.push_back({ t, (uint8_t)p, level }); }
+
+  // zákmity: 'bounces' přepnutí během spanMs po hraně, konec na 'level'
+  void bouncyEdge(Rng& r, uint32_t t, Pin p, bool level, int bounces, uint32_t spanMs) {
+    add(t, p, level);
+    bool l = level;
+    uint32_t bt = t;
+    for (int i = 0; i < bounces; i++) {
+      bt = r.range(bt, t + spanMs);     // časy zákmitů jdou po sobě
+      l = !l;
+      add(bt, p, l);
+    }
+    if (l != level) add(t + spanMs + 1, p, level);
+  }
+
+  // stisk tlačítka na holdMs (od první hrany dolů po první hranu nahoru)
+  uint32_t press(Rng& r, uint32_t t, uint32_t holdMs, int bounces) {
+    if (holdMs < 7) holdMs = 7;        // puštění až po doznění zákmitů stisku
+    bouncyEdge(r, t, PIN_SW, false, bounces, 5);
+    bouncyEdge(r, t + holdMs, PIN_SW, true, bounces, 5);
+    presses.push_back({ t, t + holdMs });
+    return t + holdMs + 6;
+  }
+
+  // 'steps' detentů (znaménko = směr), periodMs na detent; zákmity na A
+  uint32_t rotate(Rng& r, uint32_t t, int steps, uint32_t periodMs, int bounces) {
+    uint32_t q = periodMs / 4 ? periodMs / 4 : 1;
+    uint32_t start = t;
+    int n = steps > 0 ? steps : -steps;
+    for (int i = 0; i < n; i++) {
+      // CW: (1,1) -> (0,1) -> (0,0) -> (1,0) -> (1,1); A nahoru při B=0 = +1
+      // CCW: (1,1) -> (1,0) -> (0,0) -> (0,1) -> (1,1); A nahoru při B=1 = -1
+      if (steps > 0) {
+        bouncyEdge(r, t, PIN_A, false, bounces, q / 4);
+        add(t + q, PIN_B, false);
+        bouncyEdge(r, t + 2 * q, PIN_A, true, bounces, q / 4);
+        add(t + 3 * q, PIN_B, true);
+      } else {
+        add(t, PIN_B, false);
+        bouncyEdge(r, t + q, PIN_A, false, bounces, q / 4);
+        add(t + 2 * q, PIN_B, true);
+        bouncyEdge(r, t + 3 * q, PIN_A, true, bounces, q / 4);
+      }
+      t += 4 * q;
+    }
+    bursts.push_back({ start, t, steps });
+    netSteps += steps;
+    return t;
+  }
+
+  void finish() {
+    std::stable_sort(edges.begin(), edges.end(),
+                     [](const Edge& a, const Edge& b) { return a.t < b.t; });
+  }
+};
+
+// ========================
+// Vzorkování jako loop()
+// ========================
+struct LoopTiming {
+  uint32_t minMs   = 1;
+  uint32_t maxMs   = 20;
+  int      stallPct = 0;        // šance na zaseknutí na vzorek (promile * 10)
+  uint32_t stallMaxMs = 3000;
+};
+
+// typeahead skok jako foodMenuJump: po "písmenech" o velikosti bucket
+static int g_jumpCount  = 1;
+static int g_jumpBucket = 7;
+static int simJump(int index, int dir) {
+  int b = index / g_jumpBucket;
+  int next = dir > 0 ? (b + 1) * g_jumpBucket : (index % g_jumpBucket ? b * g_jumpBucket : (b - 1) * g_jumpBucket);
+  if (next > g_jumpCount) next = g_jumpCount;   // schválně i mimo rozsah – ListCursor to musí srovnat
+  return next;
+}
+
+struct Failure {
+  bool ok = true;
+  char msg[160];
+  void fail(const char* fmt, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0) {
+    if (!ok) return;
+    ok = false;
+    snprintf(msg, sizeof(msg), fmt, a, b, c);
+  }
+};
+
+struct Scenario {
+  Wave       wave;
+  LoopTiming timing;
+  bool       clean = true;      // bez zaseknutí a bez zákmitů na enkodéru
+  bool       ui    = false;     // přepínat HUD / seznam jako loop()
+  uint32_t   t0    = 0;         // absolutní začátek (millis)
+  uint32_t   lengthMs = 0;
+};
+
+struct Stats {
+  uint64_t scenarios = 0;
+  uint64_t samples   = 0;
+  uint64_t clicks    = 0;
+  uint64_t longs     = 0;
+  uint64_t gestures  = 0;
+  uint64_t listMoves = 0;
+};
+
+// ========================
+// Jeden scénář
+// ========================
+static Failure runScenario(const Scenario& sc, Rng& r, Stats& st) {
+  Failure f;
+  const std::vector<Edge>& e = sc.wave.edges;
+  size_t ei = 0;
+  bool lv[3] = { true, true, true };
+
+  ButtonDecoder     btn;
+  EncoderDecoder    enc;
+  HudEncoderGesture gesture;
+  ListCursor        list;
+  bool inList  = false;
+  long encLast = 0;
+
+  uint32_t rel = 0;
+  btn.begin(true, sc.t0);
+  enc.begin(true, true, sc.t0);
+  gesture.reset(0, sc.t0);
+
+  // události na fyzický stisk / otočení (podle času vzniku)
+  std::vector<int> pressEvents(sc.wave.presses.size(), 0);
+  std::vector<int> pressClicks(sc.wave.presses.size(), 0);
+  std::vector<int> burstEvents(sc.wave.bursts.size(), 0);
+  int  eventsSinceObservedPress = 0;
+  bool wasPressed = false;
+
+  while (rel <= sc.lengthMs && f.ok) {
+    // loop() perioda, občas zaseknutí
+    uint32_t dt = r.range(sc.timing.minMs, sc.timing.maxMs);
+    if (sc.timing.stallPct && (int)r.range(0, 999) < sc.timing.stallPct) dt = r.range(200, sc.timing.stallMaxMs);
+    rel += dt;
+    while (ei < e.size() && e[ei].t <= rel) {
+      lv[e[ei].pin] = e[ei].level;
+      ei++;
+    }
+    uint32_t now = sc.t0 + rel;
+    st.samples++;
+
+    enc.update(lv[PIN_A], lv[PIN_B], now);
+    uint8_t ev = btn.update(lv[PIN_SW], now);
+    if (g_trace && (ev || btn.pressed() != wasPressed))
+      printf("  %6u ms  sw=%d pressed=%d ev=%d pos=%ld\n", rel, lv[PIN_SW], btn.pressed(), ev, enc.position());
+
+    // invariant: nikdy obojí v jednom vzorku, nikdy víc událostí na jeden
+    // stisk, který dekodér viděl
+    if (ev == (BTN_CLICK | BTN_LONG)) f.fail("click+long v jednom vzorku @%u", rel);
+    bool p = btn.pressed();
+    if (p && !wasPressed) eventsSinceObservedPress = 0;
+    wasPressed = p;
+    if (ev) {
+      if (++eventsSinceObservedPress > 1) f.fail("2 udalosti z jednoho stisku @%u", rel);
+      if (ev & BTN_CLICK) st.clicks++;
+      if (ev & BTN_LONG)  st.longs++;
+      // přiřadit fyzickému stisku (poslední, který začal)
+      for (size_t i = sc.wave.presses.size(); i-- > 0; ) {
+        if (sc.wave.presses[i].start <= rel) {
+          pressEvents[i]++;
+          if (ev & BTN_CLICK) pressClicks[i]++;
+          break;
+        }
+      }
+    }
+
+    if (!sc.ui) {
+      int g = gesture.update(enc.position(), now);
+      if (g != HG_NONE) {
+        st.gestures++;
+        for (size_t i = sc.wave.bursts.size(); i-- > 0; ) {
+          if (sc.wave.bursts[i].start <= rel) {
+            burstEvents[i]++;
+            break;
+          }
+        }
+        // menu a zpět: enterHudMode() dá novou základnu
+        gesture.reset(enc.position(), now);
+      }
+      continue;
+    }
+
+    // UI model jako loop(): HUD <-> seznam
+    if (!inList) {
+      int g = gesture.update(enc.position(), now);
+      if (g != HG_NONE || (ev & BTN_CLICK)) {
+        st.gestures += g != HG_NONE;
+        inList = true;
+        list = ListCursor();
+        list.setCount((int)r.range(1, r.chance(20) ? 2000 : 30), LIST_ROWS);
+        g_jumpCount  = list.count;
+        g_jumpBucket = (int)r.range(1, 40);
+        encLast = enc.position();
+      }
+    } else {
+      long d = enc.position() - encLast;
+      encLast = enc.position();
+      bool fast = enc.fastSpin(now) && r.chance(50);
+      list.navigate(d, enc.accelFactor(list.count, now), fast ? simJump : nullptr, LIST_ROWS);
+      if (d) st.listMoves++;
+
+      // tabulka se mění za běhu (nádoby přes HTTP)
+      if (r.chance(1)) {
+        list.setCount((int)r.range(0, 50), LIST_ROWS);
+        g_jumpCount = list.count;
+      }
+      if (ev & BTN_CLICK) {
+        inList = false;
+        gesture.reset(enc.position(), now);
+      }
+    }
+    if (list.index < 0 || list.index >= list.count)
+      f.fail("index %u mimo [0,%u) @%u", (uint32_t)list.index, (uint32_t)list.count, rel);
+    if (list.top < 0 || list.index < list.top || list.index >= list.top + LIST_ROWS)
+      f.fail("vyber %u mimo okno od %u @%u", (uint32_t)list.index, (uint32_t)list.top, rel);
+  }
+
+  if (!f.ok) return f;
+
+  // přesná očekávání jen při čistém vzorkování
+  for (size_t i = 0; i < sc.wave.presses.size(); i++) {
+    // při zaseknutí může událost stisku vzniknout až v čase dalšího stisku,
+    // tam platí jen kontrola podle stisků, které dekodér viděl
+    if (!sc.clean) continue;
+    if (pressEvents[i] > 1) f.fail("stisk %u: %u udalosti", (uint32_t)i, (uint32_t)pressEvents[i]);
+    uint32_t hold = sc.wave.presses[i].release - sc.wave.presses[i].start;
+    if (hold >= 100 && hold + 100 <= 1500 && (pressEvents[i] != 1 || pressClicks[i] != 1))
+      f.fail("stisk %u (%u ms) neni klik", (uint32_t)i, hold);
+    if (hold >= 1500 + 50 && (pressEvents[i] != 1 || pressClicks[i] != 0))
+      f.fail("stisk %u (%u ms) neni long", (uint32_t)i, hold);
+  }
+  if (!sc.ui) {
+    for (size_t i = 0; i < sc.wave.bursts.size(); i++) {
+      int k = abs(sc.wave.bursts[i].steps);
+      if (burstEvents[i] > 1) f.fail("gesto %u (%u kroku): %u udalosti", (uint32_t)i, k, burstEvents[i]);
+      if (sc.clean && burstEvents[i] != (k >= 5 ? 1 : 0))
+        f.fail("gesto %u (%u kroku): %u udalosti", (uint32_t)i, k, burstEvents[i]);
+    }
+    if (sc.clean && enc.position() != sc.wave.netSteps)
+      f.fail("pozice enkoderu %u, ocekavano %u", (uint32_t)enc.position(), (uint32_t)sc.wave.netSteps);
+  }
+  return f;
+}
+
+// ========================
+// Generátory scénářů
+// ========================
+static Scenario makeButtons(Rng& r, bool clean) {
+  Scenario sc;
+  sc.clean = clean;
+  sc.t0 = r.chance(30) ? 0xFFFFFFFFu - r.range(0, 20000) : (uint32_t)r.next();
+  uint32_t t = 100;
+  int n = (int)r.range(1, 6);
+  for (int i = 0; i < n; i++) {
+    uint32_t hold;
+    switch (r.range(0, 3)) {
+      case 0:  hold = r.range(1, 99); break;          // ťuknutí (i kratší než debounce)
+      case 1:  hold = r.range(100, 1400); break;      // klik
+      case 2:  hold = r.range(1400, 1600); break;     // kolem hranice
+      default: hold = r.range(1550, 5000); break;     // dlouhý stisk
+    }
+    t = sc.wave.press(r, t, hold, (int)r.range(0, 6));
+    t += r.range(80, 600);
+  }
+  sc.lengthMs = t + 100;
+  if (!clean) {
+    sc.timing.stallPct = (int)r.range(1, 50);
+    sc.timing.maxMs = r.range(1, 60);
+  }
+  sc.wave.finish();
+  return sc;
+}
+
+static Scenario makeGestures(Rng& r, bool clean) {
+  Scenario sc;
+  sc.clean = clean;
+  sc.t0 = r.chance(30) ? 0xFFFFFFFFu - r.range(0, 20000) : (uint32_t)r.next();
+  uint32_t t = 100;
+  int n = (int)r.range(1, 5);
+  for (int i = 0; i < n; i++) {
+    int k = (int)r.range(1, 9) * (r.chance(50) ? 1 : -1);
+    // detent aspoň 4 fáze po 2 vzorcích, pomaleji než idle
+    uint32_t period = r.range(clean ? 4 * 2 * 20 : 4, clean ? 400 : 600);
+    t = sc.wave.rotate(r, t, k, period, clean ? 0 : (int)r.range(0, 3));
+    // klid > idleMs – další gesto začíná od nuly; se zaseknutím musí být
+    // v mezeře vzorek i po nejdelším zaseknutí (jinak se gesta spojí)
+    t += clean ? r.range(2300, 3000) : r.range(6200, 7000);
+  }
+  sc.lengthMs = t;
+  if (!clean) {
+    sc.timing.stallPct   = (int)r.range(0, 20);
+    sc.timing.stallMaxMs = 2000;   // kratší než klid mezi gesty
+    sc.timing.maxMs = r.range(1, 60);
+  }
+  sc.wave.finish();
+  return sc;
+}
+
+// všechno dohromady přes UI model (seznamy, akcelerace, skoky, změny počtu)
+static Scenario makeUi(Rng& r) {
+  Scenario sc;
+  sc.ui    = true;
+  sc.clean = false;
+  sc.t0 = r.chance(30) ? 0xFFFFFFFFu - r.range(0, 20000) : (uint32_t)r.next();
+  uint32_t t = 100;
+  int n = (int)r.range(2, 12);
+  for (int i = 0; i < n; i++) {
+    if (r.chance(40)) {
+      t = sc.wave.press(r, t, r.range(1, 2500), (int)r.range(0, 6));
+    } else {
+      int k = (int)r.range(1, r.chance(30) ? 200 : 12) * (r.chance(50) ? 1 : -1);
+      t = sc.wave.rotate(r, t, k, r.range(4, 300), (int)r.range(0, 2));
+    }
+    t += r.range(0, 2500);
+  }
+  sc.lengthMs = t;
+  sc.timing.stallPct = (int)r.range(0, 10);
+  sc.timing.maxMs = r.range(1, 40);
+  sc.wave.finish();
+  return sc;
+}
+
+static Scenario makeRandom(Rng& r) {
+  switch (r.range(0, 4)) {
+    case 0:  return makeButtons(r, true);
+    case 1:  return makeButtons(r, false);
+    case 2:  return makeGestures(r, true);
+    case 3:  return makeGestures(r, false);
+    default: return makeUi(r);
+  }
+}
+
+// ========================
+// Pevná sada – ručně psané průběhy
+// ========================
+static int runFixed(Stats& st) {
+  struct Case {
+    const char* name;
+    Scenario    sc;
+  };
+  std::vector<Case> cases;
+  Rng r(1);
+
+  {
+    Scenario sc;   // čistý klik
+    sc.wave.press(r, 100, 200, 0);
+    sc.lengthMs = 600;
+    cases.push_back({ "klik 200 ms", sc });
+  }
+  {
+    Scenario sc;   // klik se zákmity na obou hranách
+    sc.wave.press(r, 100, 300, 5);
+    sc.lengthMs = 800;
+    sc.wave.finish();
+    cases.push_back({ "klik se zakmity", sc });
+  }
+  {
+    Scenario sc;   // dlouhý stisk – jen long, po puštění nic
+    sc.wave.press(r, 100, 3000, 3);
+    sc.lengthMs = 3500;
+    sc.wave.finish();
+    cases.push_back({ "dlouhy stisk 3 s", sc });
+  }
+  {
+    Scenario sc;   // rychlé klikání
+    uint32_t t = 100;
+    for (int i = 0; i < 10; i++) t = sc.wave.press(r, t, 120, 2) + 100;
+    sc.lengthMs = t + 100;
+    sc.wave.finish();
+    cases.push_back({ "10 rychlych kliku", sc });
+  }
+  {
+    Scenario sc;   // 5 kroků doprava = jedno gesto, 4 doleva nic
+    uint32_t t = sc.wave.rotate(r, 100, 5, 200, 0) + 2500;
+    t = sc.wave.rotate(r, t, -4, 200, 0) + 2500;
+    sc.lengthMs = t;
+    sc.wave.finish();
+    cases.push_back({ "gesto +5 / -4", sc });
+  }
+  {
+    Scenario sc;   // 9 kroků = pořád jen jedna událost
+    sc.lengthMs = sc.wave.rotate(r, 100, -9, 160, 0) + 2500;
+    sc.wave.finish();
+    cases.push_back({ "gesto -9", sc });
+  }
+  {
+    Scenario sc;   // přes přetečení millis()
+    sc.t0 = 0xFFFFFFFFu - 700;
+    sc.wave.press(r, 100, 2000, 2);
+    sc.lengthMs = 2600;
+    sc.wave.finish();
+    cases.push_back({ "long pres preteceni millis", sc });
+  }
+  {
+    Scenario sc;   // zaseknutý loop: long se neztratí, klik k němu nepřibude
+    sc.clean = false;
+    sc.timing.stallPct = 500;
+    sc.wave.press(r, 100, 1800, 0);
+    sc.lengthMs = 6000;
+    sc.wave.finish();
+    cases.push_back({ "zaseknuty loop", sc });
+  }
+  {
+    Scenario sc;   // rychlé točení v seznamu
+    sc.ui = true;
+    sc.clean = false;
+    uint32_t t = sc.wave.press(r, 100, 150, 0) + 200;
+    t = sc.wave.rotate(r, t, 300, 8, 0) + 100;
+    t = sc.wave.rotate(r, t, -300, 8, 0) + 100;
+    sc.lengthMs = t;
+    sc.wave.finish();
+    cases.push_back({ "seznam rychle toceni", sc });
+  }
+
+  int failed = 0;
+  for (Case& c : cases) {
+    c.sc.wave.finish();
+    Rng rr(42);
+    Failure f = runScenario(c.sc, rr, st);
+    st.scenarios++;
+    printf("%-28s %s\n", c.name, f.ok ? "OK" : f.msg);
+    if (!f.ok) failed++;
+  }
+  return failed;
+}
+
+int main(int argc, char** argv) {
+  long long fuzz = 0;
+  uint64_t  seed = (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+  bool      verbose = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--fuzz") && i + 1 < argc)       fuzz = atoll(argv[++i]);
+    else if (!strcmp(argv[i], "--seed") && i + 1 < argc)  seed = strtoull(argv[++i], nullptr, 0);
+    else if (!strcmp(argv[i], "--verbose"))               verbose = true;
+    else {
+      fprintf(stderr, "usage: %s [--fuzz N] [--seed S] [--verbose]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  Stats st;
+  if (fuzz <= 0) {
+    int failed = runFixed(st);
+    printf("%d selhalo, %llu vzorku\n", failed, (unsigned long long)st.samples);
+    return failed ? 1 : 0;
+  }
+
+  // každý scénář má vlastní seed = seed + i, ať jde zopakovat samostatně
+  auto t0 = std::chrono::steady_clock::now();
+  for (long long i = 0; i < fuzz; i++) {
+    uint64_t s = seed + (uint64_t)i;
+    Rng r(s);
+    Scenario sc = makeRandom(r);
+    g_trace = verbose && fuzz == 1;
+    Failure f = runScenario(sc, r, st);
+    st.scenarios++;
+    if (!f.ok) {
+      printf("SELHANI: %s\n  zopakovat: %s --fuzz 1 --seed %llu\n", f.msg, argv[0], (unsigned long long)s);
+      if (verbose) {
+        printf("  t0=%u delka=%u ms, %zu hran, stall=%d, ui=%d, clean=%d\n",
+               sc.t0, sc.lengthMs, sc.wave.edges.size(), sc.timing.stallPct, sc.ui, sc.clean);
+        for (const Press& p : sc.wave.presses) printf("  stisk %u..%u ms\n", p.start, p.release);
+        for (const Burst& b : sc.wave.bursts)  printf("  otoceni %d @ %u..%u ms\n", b.steps, b.start, b.end);
+      }
+      return 1;
+    }
+  }
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  printf("%llu scenaru OK za %.2f s (%.0f scenaru/s, %.1f M/min), seed %llu\n",
+         (unsigned long long)st.scenarios, sec, st.scenarios / sec, st.scenarios / sec * 60 / 1e6,
+         (unsigned long long)seed);
+  printf("  vzorku %llu, kliku %llu, long %llu, gest %llu, posunu seznamu %llu\n",
+         (unsigned long long)st.samples, (unsigned long long)st.clicks, (unsigned long long)st.longs,
+         (unsigned long long)st.gestures, (unsigned long long)st.listMoves);
+  return 0;
+}
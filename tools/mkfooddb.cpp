@@ -0,0 +1,230 @@
+// ========================
+// Výroba obrazu databáze potravin
+// ========================
+// Z CSV udělá binární obraz pro oddíl "fooddb" (formát viz include/food_db.h).
+//
+// Překlad:
+//   g++ -O2 -std=c++17 -Iinclude tools/mkfooddb.cpp -o mkfooddb
+//
+// Vstup (CSV, hodnoty na 100 g, první řádek hlavička):
+//   id,name,kcal,protein,carbs,fat
+//   1,Jablko,52,0.3,13.8,0.2
+//
+// Výstup:
+//   ./mkfooddb foods.csv foods.bin
+//   esptool.py --chip esp32s3 write_flash 0x910000 foods.bin
+// (adresa = offset oddílu fooddb v partitions.csv)
+//
+// Jména se převedou na ASCII (česká diakritika -> bez háčků a čárek),
+// protože font displeje jiné znaky neumí.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "food_db.h"
+
+const uint32_t FOOD_DB_PARTITION_SIZE = 0x400000;
+
+struct Food {
+  uint32_t id;
+  std::string name;
+  float kcal, protein, carbs, fat;
+};
+
+// UTF-8 -> ASCII pro češtinu (a pár běžných dalších)
+static std::string toAscii(const std::string& in) {
+  static const char* MAP[][2] = {
+    {"á", "a"}, {"č", "c"}, {"ď", "d"}, {"é", "e"}, {"ě", "e"}, {"í", "i"}, {"ň", "n"},
+    {"ó", "o"}, {"ř", "r"}, {"š", "s"}, {"ť", "t"}, {"ú", "u"}, {"ů", "u"}, {"ý", "y"},
+    {"ž", "z"}, {"ä", "a"}, {"ö", "o"}, {"ü", "u"}, {"ß", "ss"},
+    {"Á", "A"}, {"Č", "C"}, {"Ď", "D"}, {"É", "E"}, {"Ě", "E"}, {"Í", "I"}, {"Ň", "N"},
+    {"Ó", "O"}, {"Ř", "R"}, {"Š", "S"}, {"Ť", "T"}, {"Ú", "U"}, {"Ů", "U"}, {"Ý", "Y"},
+    {"Ž", "Z"}, {"Ä", "A"}, {"Ö", "O"}, {"Ü", "U"},
+  };
+  std::string out;
+  for (size_t i = 0; i < in.size();) {
+    unsigned char c = in[i];
+    if (c < 0x80) {
+      if (c >= 0x20 && c != '"' && c != '\\') out += (char)c;
+      i++;
+      continue;
+    }
+    bool found = false;
+    for (auto& m : MAP) {
+      size_t len = strlen(m[0]);
+      if (in.compare(i, len, m[0]) == 0) {
+        out += m[1];
+        i += len;
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      // neznámý znak přeskočit celý (UTF-8 sekvence)
+      i++;
+      while (i < in.size() && ((unsigned char)in[i] & 0xC0) == 0x80) i++;
+    }
+  }
+  return out;
+}
+
+static uint16_t tenths(float v) {
+  if (v < 0) v = 0;
+  float t = v * 10.0f + 0.5f;
+  return t > 65535.0f ? 65535 : (uint16_t)t;
+}
+
+// jednoduchý CSV řádek, podporuje "uvozovky" ve jménu
+static std::vector<std::string> splitCsv(const std::string& line) {
+  std::vector<std::string> f;
+  std::string cur;
+  bool quoted = false;
+  for (size_t i = 0; i < line.size(); i++) {
+    char c = line[i];
+    if (quoted) {
+      if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') { cur += '"'; i++; }
+      else if (c == '"') quoted = false;
+      else cur += c;
+    } else if (c == '"') {
+      quoted = true;
+    } else if (c == ',') {
+      f.push_back(cur);
+      cur.clear();
+    } else if (c != '\r' && c != '\n') {
+      cur += c;
+    }
+  }
+  f.push_back(cur);
+  return f;
+}
+
+static void align4(std::vector<uint8_t>& img) {
+  while (img.size() % 4) img.push_back(0);
+}
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s foods.csv foods.bin\n", argv[0]);
+    return 2;
+  }
+
+  FILE* in = fopen(argv[1], "r");
+  if (!in) {
+    perror(argv[1]);
+    return 1;
+  }
+
+  std::vector<Food> foods;
+  char buf[1024];
+  int lineNo = 0;
+  while (fgets(buf, sizeof(buf), in)) {
+    lineNo++;
+    if (lineNo == 1 && strncmp(buf, "id,", 3) == 0) continue;
+    std::vector<std::string> f = splitCsv(buf);
+    if (f.size() < 6) {
+      if (f.size() > 1) fprintf(stderr, "line %d: expected 6 fields, skipped\n", lineNo);
+      continue;
+    }
+    Food food;
+    food.id      = (uint32_t)strtoul(f[0].c_str(), nullptr, 10);
+    food.name    = toAscii(f[1]);
+    food.kcal    = (float)atof(f[2].c_str());
+    food.protein = (float)atof(f[3].c_str());
+    food.carbs   = (float)atof(f[4].c_str());
+    food.fat     = (float)atof(f[5].c_str());
+    if (food.name.empty()) continue;
+    foods.push_back(food);
+  }
+  fclose(in);
+
+  std::sort(foods.begin(), foods.end(), [](const Food& a, const Food& b) { return a.id < b.id; });
+  for (size_t i = 1; i < foods.size(); i++) {
+    if (foods[i].id == foods[i - 1].id) {
+      fprintf(stderr, "duplicate id %u\n", foods[i].id);
+      return 1;
+    }
+  }
+
+  uint32_t count = (uint32_t)foods.size();
+  bool dense = count > 0 && foods.back().id - foods.front().id == count - 1;
+
+  // abecední pořadí
+  std::vector<uint32_t> byName(count);
+  for (uint32_t i = 0; i < count; i++) byName[i] = i;
+  std::sort(byName.begin(), byName.end(), [&](uint32_t a, uint32_t b) {
+    return FoodDb::compareNames(foods[a].name.c_str(), foods[b].name.c_str()) < 0;
+  });
+
+  FoodDbHeader hdr;
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.magic   = FOOD_DB_MAGIC;
+  hdr.count   = count;
+  hdr.firstId = count ? foods.front().id : 0;
+  hdr.dense   = dense ? 1 : 0;
+
+  // kyblíky podle prvního znaku (nameIndex je podle nich seřazený)
+  uint32_t pos = 0;
+  for (int b = 0; b <= FOOD_DB_BUCKETS; b++) {
+    while (pos < count && FoodDb::bucketOf(foods[byName[pos]].name[0]) < b) pos++;
+    hdr.bucketStart[b] = pos;
+  }
+  hdr.bucketStart[FOOD_DB_BUCKETS] = count;
+
+  std::vector<uint8_t> img(sizeof(FoodDbHeader));
+  align4(img);
+
+  std::string strings;
+  std::vector<FoodRecord> recs(count);
+  for (uint32_t i = 0; i < count; i++) {
+    recs[i].id         = foods[i].id;
+    recs[i].nameOffset = (uint32_t)strings.size();
+    recs[i].kcal       = tenths(foods[i].kcal);
+    recs[i].protein    = tenths(foods[i].protein);
+    recs[i].carbs      = tenths(foods[i].carbs);
+    recs[i].fat        = tenths(foods[i].fat);
+    strings += foods[i].name;
+    strings += '\0';
+  }
+
+  hdr.recordsOffset = (uint32_t)img.size();
+  img.insert(img.end(), (const uint8_t*)recs.data(), (const uint8_t*)recs.data() + count * sizeof(FoodRecord));
+  align4(img);
+
+  hdr.nameIndexOffset = (uint32_t)img.size();
+  img.insert(img.end(), (const uint8_t*)byName.data(), (const uint8_t*)byName.data() + count * 4);
+  align4(img);
+
+  hdr.stringsOffset = (uint32_t)img.size();
+  img.insert(img.end(), strings.begin(), strings.end());
+  align4(img);
+
+  hdr.imageSize = (uint32_t)img.size();
+  memcpy(img.data(), &hdr, sizeof(hdr));
+
+  if (img.size() > FOOD_DB_PARTITION_SIZE) {
+    fprintf(stderr, "image %zu B does not fit the fooddb partition (%u B)\n", img.size(), FOOD_DB_PARTITION_SIZE);
+    return 1;
+  }
+
+  // kontrola – obraz musí jít otevřít čtečkou z firmware
+  FoodDb db;
+  if (!db.open(img.data(), img.size())) {
+    fprintf(stderr, "internal error: image does not validate\n");
+    return 1;
+  }
+
+  FILE* out = fopen(argv[2], "wb");
+  if (!out) {
+    perror(argv[2]);
+    return 1;
+  }
+  fwrite(img.data(), 1, img.size(), out);
+  fclose(out);
+
+  fprintf(stderr, "%u foods, %zu B (%s ids)\n", count, img.size(), dense ? "dense" : "sparse");
+  return 0;
+}
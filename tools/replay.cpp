@@ -0,0 +1,223 @@
+// ========================
+// Přehrání nahraného záznamu HX711 na PC
+// ========================
+// Prožene trace (z /api/trace nebo ze sériové linky) stejnou pipeline jako
+// firmware (include/weight_pipeline.h, include/dynamic_weigh.h) a vypíše
+// výsledné hodnoty, časy ustálení a cenu výpočtu na vzorek. S --check
+// prožene záznam i kontrolním vážením (include/checkweigh.h).
+//
+// Překlad:
+//   g++ -O2 -std=c++17 -Iinclude tools/replay.cpp -o replay
+//
+// Použití:
+//   ./replay trace.csv [--filter N] [--stable-g G] [--stable-ms MS]
+//                      [--scale s0,s1,..] [--offset o0,o1,..] [--container-g G]
+//                      [--dynamic] [--check TARGET_G,UNDER_G,OVER_G]
+//                      [--band-g G] [--settle N] [--window-ms MS] [--quiet]
+//
+// Bez přepínačů se konfigurace bere z hlavičky záznamu, tj. tak, jak běžela
+// na zařízení – včetně nádoby (container_mg) platné při startu záznamu,
+// takže výstup odpovídá currentWeight. Na stdout jde CSV po vzorcích,
+// souhrn na stderr.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "weight_pipeline.h"
+#include "dynamic_weigh.h"
+#include "checkweigh.h"
+
+struct Sample {
+  uint64_t tUs;
+  long raw[WP_MAX_CELLS];
+};
+
+static int parseList(const char* s, double* out, int max) {
+  int n = 0;
+  while (*s && n < max) {
+    char* end;
+    out[n++] = strtod(s, &end);
+    if (*end != ',') break;
+    s = end + 1;
+  }
+  return n;
+}
+
+static const char* headerValue(const std::string& line, const char* key) {
+  size_t p = line.find(key);
+  if (p == std::string::npos) return nullptr;
+  return line.c_str() + p + strlen(key);
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s trace.csv [--filter N] [--stable-g G] [--stable-ms MS]"
+                    " [--scale a,b] [--offset a,b] [--container-g G] [--dynamic] [--check T,U,O] [--quiet]\n", argv[0]);
+    return 2;
+  }
+
+  FILE* f = fopen(argv[1], "r");
+  if (!f) {
+    perror(argv[1]);
+    return 1;
+  }
+
+  WeightPipeline wp;
+  int cells = 1, zones = 1, filter = 1;
+  int32_t containerMg = 0;
+  std::vector<Sample> samples;
+
+  // hlavička + data
+  char buf[512];
+  while (fgets(buf, sizeof(buf), f)) {
+    std::string line(buf);
+    if (line[0] == '#') {
+      double v[WP_MAX_CELLS];
+      const char* p;
+      if ((p = headerValue(line, "cells="))) cells = atoi(p);
+      if ((p = headerValue(line, "zones="))) zones = atoi(p);
+      if ((p = headerValue(line, "# zone="))) {
+        int n = parseList(p, v, WP_MAX_CELLS);
+        for (int i = 0; i < n; i++) wp.cellZone[i] = (int)v[i];
+      }
+      if ((p = headerValue(line, "# offset="))) {
+        int n = parseList(p, v, WP_MAX_CELLS);
+        for (int i = 0; i < n; i++) wp.cellOffset[i] = (long)v[i];
+      }
+      if ((p = headerValue(line, "# scale="))) {
+        int n = parseList(p, v, WP_MAX_CELLS);
+        for (int i = 0; i < n; i++) wp.cellScale[i] = (float)v[i];
+      }
+      if ((p = headerValue(line, "filter="))) filter = atoi(p);
+      if ((p = headerValue(line, "stable_g="))) wp.stableThresholdMg = wpGramsToMg((float)atof(p));
+      if ((p = headerValue(line, "stable_us="))) wp.stableTimeUs = (uint32_t)atol(p);
+      if ((p = headerValue(line, "container_mg="))) containerMg = (int32_t)atol(p);
+      continue;
+    }
+    if (line.compare(0, 4, "t_us") == 0) continue;
+
+    Sample s;
+    char* end;
+    s.tUs = strtoull(buf, &end, 10);
+    if (end == buf) continue;  // smetí ze sériové linky
+    int n = 0;
+    while (*end == ',' && n < WP_MAX_CELLS) {
+      s.raw[n++] = strtol(end + 1, &end, 10);
+    }
+    if (n < cells) continue;
+    samples.push_back(s);
+  }
+  fclose(f);
+
+  if (cells < 1 || cells > WP_MAX_CELLS || zones < 1 || zones > WP_MAX_ZONES) {
+    fprintf(stderr, "bad header: cells=%d zones=%d\n", cells, zones);
+    return 1;
+  }
+
+  bool quiet = false, dynamic = false, check = false;
+  CheckWeighParams cp;
+  for (int i = 2; i < argc; i++) {
+    const char* a = argv[i];
+    const char* next = (i + 1 < argc) ? argv[i + 1] : "";
+    double v[WP_MAX_CELLS];
+    if (!strcmp(a, "--filter"))          { filter = atoi(next); i++; }
+    else if (!strcmp(a, "--stable-g"))   { wp.stableThresholdMg = wpGramsToMg((float)atof(next)); i++; }
+    else if (!strcmp(a, "--stable-ms"))  { wp.stableTimeUs = (uint32_t)(atof(next) * 1000); i++; }
+    else if (!strcmp(a, "--scale"))      { int n = parseList(next, v, WP_MAX_CELLS); for (int k = 0; k < n; k++) wp.cellScale[k] = (float)v[k]; i++; }
+    else if (!strcmp(a, "--offset"))     { int n = parseList(next, v, WP_MAX_CELLS); for (int k = 0; k < n; k++) wp.cellOffset[k] = (long)v[k]; i++; }
+    else if (!strcmp(a, "--container-g")) { containerMg = wpGramsToMg((float)atof(next)); i++; }
+    else if (!strcmp(a, "--dynamic"))    { dynamic = true; }
+    else if (!strcmp(a, "--check")) {
+      int n = parseList(next, v, 3);
+      if (n > 0) cp.targetMg = wpGramsToMg((float)v[0]);
+      if (n > 1) cp.underMg  = wpGramsToMg((float)v[1]);
+      if (n > 2) cp.overMg   = wpGramsToMg((float)v[2]);
+      check = true;
+      i++;
+    }
+    else if (!strcmp(a, "--band-g"))     { cp.settleBandMg = wpGramsToMg((float)atof(next)); i++; }
+    else if (!strcmp(a, "--settle"))     { cp.settleSamples = atoi(next); i++; }
+    else if (!strcmp(a, "--window-ms"))  { cp.windowUs = (uint32_t)(atof(next) * 1000); i++; }
+    else if (!strcmp(a, "--quiet"))      { quiet = true; }
+    else {
+      fprintf(stderr, "unknown option %s\n", a);
+      return 2;
+    }
+  }
+
+  wp.begin(cells, zones);
+  wp.setFilterLength(filter);
+  wp.setContainerTare(containerMg);
+  DynamicWeigher dw;
+  CheckWeigher cw(cp);
+  static const char* VERDICT_NAMES[] = { "none", "pass", "under", "over", "unsettled" };
+
+  if (!quiet) printf(dynamic ? "t_us,weight,stable,dyn_state,dyn_value\n" : "t_us,weight,stable\n");
+
+  // časy ustálení: od ztráty stability po její návrat
+  bool wasStable = false;
+  uint64_t unstableSinceUs = samples.empty() ? 0 : samples[0].tUs;
+  std::vector<double> settleMs;
+  int holds = 0;
+
+  double cpuNs = 0.0;
+  for (const Sample& s : samples) {
+    auto t0 = std::chrono::steady_clock::now();
+    wp.process(s.raw, s.tUs);
+    if (dynamic && dw.addSample(wp.totalMg / 1000.0f)) holds++;
+    bool verdict = check && cw.addSample(wp.rawTotalMg, s.tUs);
+    auto t1 = std::chrono::steady_clock::now();
+    cpuNs += std::chrono::duration<double, std::nano>(t1 - t0).count();
+
+    if (wasStable && !wp.stable) unstableSinceUs = s.tUs;
+    if (!wasStable && wp.stable) settleMs.push_back((s.tUs - unstableSinceUs) / 1000.0);
+    wasStable = wp.stable;
+
+    if (verdict) {
+      char v[16];
+      wpFormatMg(cw.getLastMg(), 3, v);
+      fprintf(stderr, "check:       %.3f s  %s g  %s\n", (s.tUs - samples[0].tUs) / 1e6, v,
+              VERDICT_NAMES[cw.getVerdict()]);
+    }
+
+    if (quiet) continue;
+    char w[16];
+    wpFormatMg(wp.totalMg, 3, w);
+    if (dynamic) {
+      printf("%llu,%s,%d,%d,%.3f\n", (unsigned long long)s.tUs, w, wp.stable ? 1 : 0,
+             (int)dw.getState(), dw.getState() == DW_HELD ? dw.getHeld() : dw.getEstimate());
+    } else {
+      printf("%llu,%s,%d\n", (unsigned long long)s.tUs, w, wp.stable ? 1 : 0);
+    }
+  }
+
+  // souhrn
+  size_t n = samples.size();
+  double durS = n > 1 ? (samples[n - 1].tUs - samples[0].tUs) / 1e6 : 0.0;
+  fprintf(stderr, "samples:     %zu (%.2f s, %.1f SPS)\n", n, durS, durS > 0 ? (n - 1) / durS : 0.0);
+  fprintf(stderr, "config:      cells=%d filter=%d stable_g=%.3f stable_ms=%.0f container_g=%.3f\n",
+          cells, wp.filterLength, wp.stableThresholdMg / 1000.0, wp.stableTimeUs / 1000.0,
+          wp.containerTareMg / 1000.0);
+  if (!settleMs.empty()) {
+    double sum = 0, mx = 0;
+    for (double v : settleMs) { sum += v; if (v > mx) mx = v; }
+    fprintf(stderr, "settles:     %zu, mean %.0f ms, max %.0f ms\n", settleMs.size(), sum / settleMs.size(), mx);
+  } else {
+    fprintf(stderr, "settles:     0\n");
+  }
+  if (dynamic) fprintf(stderr, "dyn holds:   %d\n", holds);
+  if (check) {
+    const CheckWeighStats& st = cw.getStats();
+    fprintf(stderr, "check:       %u items (pass %u, under %u, over %u, unsettled %u, aborted %u)\n",
+            st.total, st.pass, st.under, st.over, st.unsettled, st.aborted);
+    fprintf(stderr, "check:       mean %.3f g, sd %.3f g, settle %.0f ms avg / %.0f ms max, %.1f items/min\n",
+            st.mean / 1000.0, cw.stddevMg() / 1000.0, cw.meanSettleUs() / 1000.0, st.settleUsMax / 1000.0,
+            n > 1 ? cw.itemsPerMinute(samples[n - 1].tUs) : 0.0f);
+  }
+  fprintf(stderr, "cpu:         %.0f ns/sample\n", n ? cpuNs / n : 0.0);
+  return 0;
+}
@@ -0,0 +1,168 @@
+// ========================
+// Příjem binárního UDP streamu z váhy
+// ========================
+// Čte datagramy podle include/stream_proto.h, hlídá ztráty podle seq
+// a každou sekundu vypíše propustnost. Hodí se na ověření, že logger
+// dostává všech 80 SPS i při zatížené síti.
+//
+// Překlad (Linux / macOS):
+//   g++ -O2 -std=c++17 -Iinclude tools/udprecv.cpp -o udprecv
+//
+// Použití:
+//   ./udprecv [--port 5005] [--group 239.1.2.3] [--seconds N] [--csv] [--quiet]
+//
+// Na váze: curl -d "enabled=1&host=239.1.2.3&port=5005&batch=8" http://vaha-xxxxxx.local/api/stream
+// (vaha-xxxxxx = deviceId, viz /api/summary nebo výpis při startu; jinak IP váhy. Unicast:
+// host = IP počítače s udprecv, pak bez --group)
+//
+// Se --csv jde na stdout každý vzorek (seq,t_us,grams,flags,raw0,..),
+// statistiky vždy na stderr.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include "stream_proto.h"
+
+static double nowS() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char** argv) {
+  int port = 5005;
+  const char* group = nullptr;
+  double seconds = 0;
+  bool csv = false, quiet = false;
+
+  for (int i = 1; i < argc; i++) {
+    const char* a = argv[i];
+    const char* next = (i + 1 < argc) ? argv[i + 1] : "";
+    if (!strcmp(a, "--port"))          { port = atoi(next); i++; }
+    else if (!strcmp(a, "--group"))    { group = next; i++; }
+    else if (!strcmp(a, "--seconds"))  { seconds = atof(next); i++; }
+    else if (!strcmp(a, "--csv"))      { csv = true; }
+    else if (!strcmp(a, "--quiet"))    { quiet = true; }
+    else {
+      fprintf(stderr, "usage: %s [--port P] [--group ADDR] [--seconds N] [--csv] [--quiet]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0) {
+    perror("socket");
+    return 1;
+  }
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  // při 80 SPS a malém batch chodí stovky paketů za sekundu – větší buffer
+  int rcvbuf = 1 << 20;
+  setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family      = AF_INET;
+  addr.sin_port        = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+    perror("bind");
+    return 1;
+  }
+
+  if (group) {
+    struct ip_mreq mreq;
+    memset(&mreq, 0, sizeof(mreq));
+    if (inet_pton(AF_INET, group, &mreq.imr_multiaddr) != 1) {
+      fprintf(stderr, "bad group %s\n", group);
+      return 2;
+    }
+    mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+    if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0) {
+      perror("IP_ADD_MEMBERSHIP");
+      return 1;
+    }
+  }
+
+  // probouzet se aspoň jednou za 200 ms kvůli výpisu a --seconds
+  struct timeval tv = { 0, 200000 };
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+  fprintf(stderr, "listening on udp %d%s%s\n", port, group ? " group " : "", group ? group : "");
+  if (csv) printf("seq,t_us,grams,flags,raw...\n");
+
+  StreamLossTracker loss;
+  uint64_t packets = 0, bad = 0, bytes = 0;
+  uint64_t secSamples = 0, secPackets = 0, secLost = 0;
+  uint64_t firstDevUs = 0, lastDevUs = 0;
+  double start = nowS(), lastReport = start;
+  uint8_t buf[2048];
+
+  for (;;) {
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    double t = nowS();
+
+    if (n > 0) {
+      StreamHeader h;
+      if (!streamParseHeader(buf, (size_t)n, h)) {
+        bad++;
+      } else {
+        uint64_t lateBefore = loss.late;
+        uint32_t gap = loss.feed(h);
+        packets++;
+        bytes += n;
+        if (loss.late == lateBefore) {
+          secSamples += h.count;
+          secPackets++;
+          secLost    += gap;
+        }
+        if (gap && !quiet) {
+          fprintf(stderr, "gap: %u samples before seq %u\n", gap, h.seq);
+        }
+
+        StreamSample s;
+        for (int i = 0; i < h.count; i++) {
+          streamGetSample(buf, h, i, s);
+          if (!firstDevUs) firstDevUs = s.tUs;
+          lastDevUs = s.tUs;
+          if (!csv) continue;
+          printf("%u,%llu,%.3f,%u", s.seq, (unsigned long long)s.tUs, s.mg / 1000.0, s.flags);
+          for (int c = 0; c < h.cells; c++) printf(",%d", s.raw[c]);
+          printf("\n");
+        }
+      }
+    }
+
+    if (t - lastReport >= 1.0) {
+      double dt = t - lastReport;
+      if (!quiet) {
+        fprintf(stderr, "%6.1f s  %6.1f SPS  %5.1f pkt/s  lost %llu\n",
+                t - start, secSamples / dt, secPackets / dt, (unsigned long long)secLost);
+      }
+      secSamples = secPackets = secLost = 0;
+      lastReport = t;
+    }
+    if (seconds > 0 && t - start >= seconds) break;
+  }
+
+  double dur = nowS() - start;
+  double devS = (lastDevUs - firstDevUs) / 1e6;
+  uint64_t expected = loss.received + loss.lost;
+  fprintf(stderr, "\npackets:   %llu (%llu bad, %.1f kB/s)\n",
+          (unsigned long long)packets, (unsigned long long)bad, dur > 0 ? bytes / dur / 1000.0 : 0.0);
+  fprintf(stderr, "samples:   %llu received, %.1f SPS by device clock\n",
+          (unsigned long long)loss.received, devS > 0 ? (loss.received - 1) / devS : 0.0);
+  fprintf(stderr, "lost:      %llu (%.3f %%)\n", (unsigned long long)loss.lost,
+          expected ? 100.0 * loss.lost / expected : 0.0);
+  fprintf(stderr, "late/dup:  %llu\n", (unsigned long long)loss.late);
+  fprintf(stderr, "resyncs:   %u\n", loss.resyncs);
+  close(fd);
+  return loss.lost ? 3 : 0;
+}